@@ -20,6 +20,18 @@
 #define MB_BKD_ACK_TMO_MS_DEF       300 // 响应超时时间
 #define MB_BKD_BYTE_TMO_MS_DEF      32  // 字节间隔超时时间
 
+#define MB_BKD_WAIT_RX              1   // wait() 返回: 有新数据
+#define MB_BKD_WAIT_EOF             2   // wait() 返回: 帧结束(RTU t3.5 静默)
+
+#define MB_RTU_CHAR_BITS            11  // RTU 单字符位数(起始+数据+校验/停止)
+
+#define MB_BKD_RSV_SIZE             260 // 流式后端(TCP/SOCK)帧重组残留缓冲区大小, 不小于最大TCP帧
+#define MB_RTU_RX_BUFSZ             512 // RTU串口接收fifo大小, 不小于两帧, 避免高波特率下溢出
+
+#define MB_RTU_DE_SOFT              0   // RS485 DE 软件控制: 发送函数返回后释放(缺省)
+#define MB_RTU_DE_TC                1   // RS485 DE 在发送完成(TC)中断中释放, 需串口DMA发送
+#define MB_RTU_DE_HW                2   // RS485 DE 由USART硬件控制(DEM), 引脚须配置为USARTx_DE复用功能
+
 //-----------------------------------------------------------------------------
 #define MB_USING_PORT_RTT
 #if defined(MB_USING_PORT_RTT)
@@ -51,6 +63,9 @@ typedef enum{
  *        [2]parity   : 校验位
  *        [3]pin      ：收发控制引脚, <0 表示不使用
  *        [4]lvl      : 发送控制电平
+ *        [5]*tmr     : t3.5 帧间隔硬件定时器名称, NULL 表示不使用
+ *        [6]dma      : 1-使用DMA收发(空闲中断断帧, 需开启串口DMA), 0-中断收发
+ *        [7]de_mode  : RS485 DE 控制方式, MB_RTU_DE_SOFT/MB_RTU_DE_TC/MB_RTU_DE_HW
  */
 typedef struct{
     char *dev;
@@ -58,6 +73,9 @@ typedef struct{
     int parity;
     int pin;
     int lvl;
+    char *tmr;
+    int dma;
+    int de_mode;
 }mb_backend_param_rtu_t;
 
 
@@ -100,6 +118,14 @@ typedef int (* modbus_bkd_ops_read_t)(void *hinst, uint8_t *buf, int bufsize);
 typedef int (* modbus_bkd_ops_write_t)(void *hinst, uint8_t *buf, int size);
 //清空接收缓存, 成功返回0, 错误返回-1
 typedef int (* modbus_bkd_ops_flush_t)(void *hinst);
+//阻塞等待接收数据, 有数据返回1, 帧结束返回2, 超时返回0, 错误返回-1
+typedef int (* modbus_bkd_ops_wait_t)(void *hinst, int tmo_ms);
+
+//接收中断中累计的CRC, len=0时从未读数据处重新开始累计, len>0时返回最近len字节的校验结果: 1-正确, 0-错误, -1-未知
+typedef int (* modbus_bkd_ops_rx_crc_t)(void *hinst, int len);
+
+//帧长度预测, 返回完整帧长度, 数据不足返回0, 无法预测返回-1
+typedef int (* modbus_bkd_frm_len_t)(const uint8_t *buf, int len, int type);
 
 typedef struct{
     modbus_bkd_ops_open_t open;
@@ -107,6 +133,8 @@ typedef struct{
     modbus_bkd_ops_read_t read;
     modbus_bkd_ops_write_t write;
     modbus_bkd_ops_flush_t flush;
+    modbus_bkd_ops_wait_t wait;     //可为NULL, 为NULL时读数据使用轮询
+    modbus_bkd_ops_rx_crc_t rx_crc; //可为NULL, 为NULL时由帧解析计算CRC
 }mb_backend_ops_t;
 
 
@@ -143,11 +171,14 @@ typedef struct{
     int byte_tmo_ms;
     /**
      * @brief 底层句柄
-     * - RTU:  rt_device_t*
+     * - RTU:  RTU 端口实例（内含 rt_device_t）
      * - TCP/SOCK: int socket fd
      * - 未打开时为 NULL
      */
     void *hinst;
+    /** @brief 流式后端帧重组: 上次读取中超出本帧的残留数据, 下次读取优先取用 */
+    int rsv_len;
+    uint8_t rsv[MB_BKD_RSV_SIZE];
 }mb_backend_t;
 
 
@@ -163,6 +194,10 @@ int modbus_port_rtu_close(void *hinst);//关闭, 成功返回0, 错误返回-1
 int modbus_port_rtu_read(void *hinst, uint8_t *buf, int bufsize);//接收数据, 返回接收到的数据长度, 0表示超时, 错误返回-1
 int modbus_port_rtu_write(void *hinst, uint8_t *buf, int size);//发送数据, , 返回成功发送的数据长度, 错误返回-1
 int modbus_port_rtu_flush(void *hinst);//清空接收缓存, 成功返回0, 错误返回-1
+#ifdef MB_USING_EVENT_RECV
+int modbus_port_rtu_wait(void *hinst, int tmo_ms);//阻塞等待接收数据, 有数据返回1, 帧结束返回2, 超时返回0, 错误返回-1
+#endif
+int modbus_rtu_t35_us(int baudrate);//按波特率计算帧间隔 t3.5(微秒)
 #endif
 
 #if (defined(MB_USING_TCP_BACKEND) || defined(MB_USING_SOCK_BACKEND))
@@ -171,6 +206,9 @@ int modbus_port_tcp_close(void *hinst);//关闭, 成功返回0, 错误返回-1
 int modbus_port_tcp_read(void *hinst, uint8_t *buf, int bufsize);//接收数据, 返回接收到的数据长度, 0表示超时, 错误返回-1
 int modbus_port_tcp_write(void *hinst, uint8_t *buf, size_t size);//发送数据, , 返回成功发送的数据长度, 错误返回-1
 int modbus_port_tcp_flush(void *hinst);//清空接收缓存, 成功返回0, 错误返回-1
+#ifdef MB_USING_EVENT_RECV
+int modbus_port_tcp_wait(void *hinst, int tmo_ms);//阻塞等待接收数据, 有数据返回1, 超时返回0, 错误返回-1
+#endif
 #endif
 
 
@@ -180,8 +218,12 @@ int modbus_backend_open(mb_backend_t *backend);//打开后端, 成功返回0, 
 int modbus_backend_close(mb_backend_t *backend);//关闭后端, 成功返回0, 错误返回-1
 int modbus_backend_config(mb_backend_t *backend, int ack_tmo_ms, int byte_tmo_ms);//配置后端超时参数, 成功返回0, 错误返回-1
 int modbus_backend_read(mb_backend_t *backend, uint8_t *buf, int bufsize);//从后端读数据, 返回读取到数据长度, 0表示超时, 错误返回-1
+int modbus_backend_read_frame(mb_backend_t *backend, uint8_t *buf, int bufsize, modbus_bkd_frm_len_t frm_len, int type);//从后端读一帧, 帧完整时立即返回, 返回值同modbus_backend_read
+int modbus_backend_read_frame_tmo(mb_backend_t *backend, uint8_t *buf, int bufsize, modbus_bkd_frm_len_t frm_len, int type, int ack_tmo_ms);//同上, 应答超时由参数指定
 int modbus_backend_write(mb_backend_t *backend, uint8_t *buf, int size);//向后端写数据, 返回已发送数据长度, 错误返回-1
 int modbus_backend_flush(mb_backend_t *backend);//清空后端接收缓存, 成功返回0, 错误返回-1
+int modbus_backend_discard(mb_backend_t *backend, int silence_ms, int max_ms);//清空并丢弃数据直到静默silence_ms, 最长max_ms, 返回丢弃字节数, 错误返回-1
+int modbus_backend_rx_crc(mb_backend_t *backend, int len);//取最近一帧len字节在接收中断中累计的CRC校验结果, 1-正确, 0-错误, -1-未知
 
 
 
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+#ifndef APPLICATIONS_MODBUS_INC_MODBUS_BUS_H_
+#define APPLICATIONS_MODBUS_INC_MODBUS_BUS_H_
+
+#include "modbus_instance.h"
+
+#if (defined(MB_USING_BUS) && defined(MB_USING_MASTER))
+
+#ifndef MB_BUS_SLAVE_MAX
+#define MB_BUS_SLAVE_MAX        32  //一条总线上最大从机数
+#endif
+
+#ifndef MB_BUS_OFFLINE_FAILS
+#define MB_BUS_OFFLINE_FAILS    3   //连续失败次数达到此值判为离线
+#endif
+
+#ifndef MB_BUS_PROBE_MS
+#define MB_BUS_PROBE_MS         5000    //离线从机的探测间隔, 期间对该从机的请求直接失败
+#endif
+
+#ifndef MB_BUS_RTO_MIN_MS
+#define MB_BUS_RTO_MIN_MS       20      //自适应应答超时下限
+#endif
+
+#ifndef MB_BUS_RTO_MAX_MS
+#define MB_BUS_RTO_MAX_MS       1000    //自适应应答超时上限
+#endif
+
+#ifndef MB_BUS_BACKOFF_BASE_MS
+#define MB_BUS_BACKOFF_BASE_MS  100     //首次超时后暂停轮询该从机的时间, 连续超时逐次加倍
+#endif
+
+#ifndef MB_BUS_BACKOFF_MAX_MS
+#define MB_BUS_BACKOFF_MAX_MS   10000   //暂停轮询时间上限
+#endif
+
+typedef struct mb_slave_ctx mb_slave_ctx_t;
+
+/**
+ * @brief 轮询点完成回调, 在总线线程中调用, 不要在回调中阻塞
+ * @param ctx 从机上下文
+ * @param idx 轮询点索引
+ * @param rst 结果, 与同步接口一致: >0-成功, 0-超时或通信失败, <0-异常码取负
+ */
+typedef void (*modbus_bus_cb_t)(mb_slave_ctx_t *ctx, int idx, int rst);
+
+typedef struct{
+    uint8_t  fc;                //功能码
+    uint16_t addr;              //起始地址
+    int      nb;                //数量
+    void    *pdata;             //数据, 按功能码解释(同 modbus_master_call)
+}mb_bus_point_t;//从机轮询点
+
+typedef enum{
+    MB_SLAVE_ONLINE = 0,        //在线(断路器闭合)
+    MB_SLAVE_OFFLINE,           //离线(断路器断开), 请求直接失败不占用总线
+    MB_SLAVE_PROBING,           //探测(断路器半开), 允许一个请求, 有应答则恢复在线
+}mb_slave_state_t;
+
+typedef struct{
+    uint32_t req_cnt;           //请求次数
+    uint32_t ok_cnt;            //成功次数
+    uint32_t tmo_cnt;           //超时或通信失败次数
+    uint32_t exc_cnt;           //异常应答次数
+    uint32_t skip_cnt;          //离线期间直接失败的请求次数
+    int      rtt_ms;            //最近一次成功请求的往返时间
+    int      rtt_max_ms;        //最大往返时间
+}mb_slave_stat_t;//从机统计
+
+struct mb_slave_ctx{
+    //配置
+    uint8_t  saddr;             //从机地址
+    int      ack_tmo_ms;        //固定应答超时, <=0按往返时间自适应(初值为总线默认值)
+    int      byte_tmo_ms;       //字节超时, <=0使用总线默认值
+    mb_word_order_t order;      //32位数据字序
+    const mb_bus_point_t *points;//轮询点表, 可为NULL
+    int      num;               //轮询点数量
+    modbus_bus_cb_t cb;         //轮询点完成回调, 可为NULL
+    void    *arg;               //用户参数
+
+    //运行状态, 由总线维护
+    int      next;              //下一个轮询点
+    mb_slave_state_t state;     //健康状态
+    int      fail_cnt;          //连续失败次数
+    int      srtt;              //平滑往返时间(毫秒, 放大8倍), 0表示尚无样本
+    int      rttvar;            //往返时间偏差(毫秒, 放大4倍)
+    int      rto_ms;            //当前应答超时, 连续超时时加倍
+    long long hold_ms;          //退避截止时间, 此前轮询跳过该从机; 离线时为下次探测时间
+    mb_slave_stat_t stat;       //统计
+};
+
+typedef struct{
+    mb_inst_t *hinst;                       //总线实例, 独占后端
+    int ack_tmo_ms;                         //默认应答超时
+    int byte_tmo_ms;                        //默认字节超时
+    int num;                                //从机数量
+    int cur;                                //轮询游标
+    mb_slave_ctx_t *slave[MB_BUS_SLAVE_MAX];//从机上下文
+}mb_bus_t;//多从机总线
+
+//初始化从机上下文为默认配置(使用总线超时, ABCD字序, 无轮询点)
+void modbus_slave_ctx_init(mb_slave_ctx_t *ctx, uint8_t saddr);
+//创建总线, 参数同modbus_create, 成功返回指针, 失败返回NULL
+mb_bus_t *modbus_bus_create(mb_backend_type_t type, const mb_backend_param_t *param);
+//销毁总线及其实例, 从机上下文由调用者管理
+void modbus_bus_destroy(mb_bus_t *bus);
+//添加从机, 上下文须在总线使用期间保持有效, 成功返回0, 已满或地址重复返回-1
+int modbus_bus_add_slave(mb_bus_t *bus, mb_slave_ctx_t *ctx);
+//按从机地址查找上下文, 未找到返回NULL
+mb_slave_ctx_t *modbus_bus_find(const mb_bus_t *bus, uint8_t saddr);
+//以从机上下文执行一次请求, pdata按功能码解释(同modbus_master_call), 返回值同对应同步接口, 从机离线且未到探测时间时直接返回0
+int modbus_bus_call(mb_bus_t *bus, mb_slave_ctx_t *ctx, uint8_t fc, uint16_t addr, int nb, void *pdata);
+//按从机字序读取32位无符号数(0x03/0x04), nb为数值个数, 成功返回nb, 返回值同同步接口
+int modbus_bus_read_u32(mb_bus_t *bus, mb_slave_ctx_t *ctx, uint8_t fc, uint16_t addr, int nb, uint32_t *pvals);
+//按从机字序读取浮点数(0x03/0x04), 返回值同modbus_bus_read_u32
+int modbus_bus_read_f32(mb_bus_t *bus, mb_slave_ctx_t *ctx, uint8_t fc, uint16_t addr, int nb, float *pvals);
+//总线轮询, 从机间轮流各执行一个轮询点(跳过退避中的从机), 返回执行结果, 无可执行轮询点返回0
+int modbus_bus_poll(mb_bus_t *bus);
+//打印每个从机的状态和统计
+void modbus_bus_dump(const mb_bus_t *bus);
+
+#endif
+
+
+
+#endif /* APPLICATIONS_MODBUS_INC_MODBUS_BUS_H_ */
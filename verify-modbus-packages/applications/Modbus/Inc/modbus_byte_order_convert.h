@@ -12,6 +12,15 @@
 
 #include "bsp_sys.h"
 
+/**
+ * 32位数据(两个寄存器)在线路上的字节顺序, 以数值0xAABBCCDD为例
+ */
+typedef enum{
+    MB_WORD_ORDER_ABCD = 0,     //大端, 高字在前(Modbus标准)
+    MB_WORD_ORDER_CDAB,         //字交换, 低字在前(常见于PLC)
+    MB_WORD_ORDER_BADC,         //字内字节交换
+    MB_WORD_ORDER_DCBA,         //小端
+}mb_word_order_t;
 
 int modbus_cvt_u8_put(uint8_t *buf, uint8_t val);
 int modbus_cvt_u8_get(const uint8_t *buf, uint8_t *pval);
@@ -21,8 +30,14 @@ int modbus_cvt_u32_put(uint8_t *buf, uint32_t val);
 int modbus_cvt_u32_get(const uint8_t *buf, uint32_t *pval);
 int modbus_cvt_f32_put(uint8_t *buf, float val);
 int modbus_cvt_f32_get(const uint8_t *buf, float *pval);
+int modbus_cvt_u16_put_block(uint8_t *buf, const uint16_t *pregs, int nb);//批量写入16位寄存器(大端序), 允许buf与pregs为同一地址, 返回写入字节数
+int modbus_cvt_u16_get_block(const uint8_t *buf, uint16_t *pregs, int nb);//批量读取16位寄存器(大端序), 允许buf与pregs为同一地址, 返回读取字节数
 uint8_t modbus_bitmap_get(const uint8_t *pbits, int idx);//从位表中读指定索引的位
 void modbus_bitmap_set(uint8_t *pbits, int idx, uint8_t bit);//向位表中写指定索引的位
+int modbus_cvt_u32_put_block(uint8_t *buf, const uint32_t *pvals, int nb, mb_word_order_t order);//批量写入32位数据(按字序), 返回写入字节数
+int modbus_cvt_u32_get_block(const uint8_t *buf, uint32_t *pvals, int nb, mb_word_order_t order);//批量读取32位数据(按字序), 返回读取字节数
+int modbus_cvt_f32_put_block(uint8_t *buf, const float *pvals, int nb, mb_word_order_t order);//批量写入浮点数(按字序), 返回写入字节数
+int modbus_cvt_f32_get_block(const uint8_t *buf, float *pvals, int nb, mb_word_order_t order);//批量读取浮点数(按字序), 返回读取字节数
 
 
 
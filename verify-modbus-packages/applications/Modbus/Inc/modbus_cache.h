@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+#ifndef APPLICATIONS_MODBUS_INC_MODBUS_CACHE_H_
+#define APPLICATIONS_MODBUS_INC_MODBUS_CACHE_H_
+
+#include "modbus_instance.h"
+
+#if (defined(MB_USING_CACHE) && defined(MB_USING_MASTER))
+
+#ifndef MB_CACHE_ENTRY_MAX
+#define MB_CACHE_ENTRY_MAX      8   //缓存项数量(1~32)
+#endif
+
+#if ((MB_CACHE_ENTRY_MAX < 1) || (MB_CACHE_ENTRY_MAX > 32))
+#error MB_CACHE_ENTRY_MAX must be 1~32!
+#endif
+
+typedef struct{
+    uint8_t  used;              //有效标志
+    uint8_t  loading;           //正在从总线加载
+    uint8_t  stale;             //加载期间被写请求失效, 完成后不作为新鲜数据
+    uint8_t  saddr;             //从机地址
+    uint8_t  fc;                //功能码, 0x01~0x04
+    uint16_t addr;              //起始地址
+    int      nb;                //数量
+    int      rst;               //最近一次加载结果
+    uint32_t seq;               //加载完成序号, 等待者据此判断本次加载已完成
+    long long time_ms;          //数据获取时间
+    uint16_t data[MODBUS_READ_REG_MAX];//数据, 寄存器为主机序, 位为低位在前的位表
+}mb_cache_entry_t;//缓存项
+
+typedef struct mb_cache{
+    mb_inst_t *hinst;           //所属实例
+    rt_mutex_t lock;            //缓存表锁
+    rt_mutex_t bus;             //总线锁, 经缓存发出的请求互斥访问实例
+    rt_event_t evt;             //加载完成通知, 每个缓存项一个事件位
+    uint32_t hit_cnt;           //命中次数
+    uint32_t miss_cnt;          //未命中(访问总线)次数
+    uint32_t join_cnt;          //合并到在途加载的次数
+    mb_cache_entry_t entry[MB_CACHE_ENTRY_MAX];
+}mb_cache_t;//主机读缓存
+
+//创建读缓存并挂接到实例, 此后实例的写请求自动使缓存对应区间失效, 成功返回指针, 失败返回NULL
+mb_cache_t *modbus_cache_create(mb_inst_t *hinst);
+//销毁读缓存并从实例上摘除
+void modbus_cache_destroy(mb_cache_t *cache);
+//经缓存读取(0x01~0x04), 缓存数据未超过max_age_ms时不访问总线, 返回值同对应同步接口
+int modbus_cache_read(mb_cache_t *cache, uint8_t saddr, uint8_t fc, uint16_t addr, int nb, void *pdata, int max_age_ms);
+//经缓存的总线锁执行任意请求(同modbus_master_call), 多线程共享实例时写请求使用此接口
+int modbus_cache_call(mb_cache_t *cache, uint8_t saddr, uint8_t fc, uint16_t addr, int nb, void *pdata);
+//使与写请求(0x05/0x06/0x0F/0x10/0x16/0x17)区间重叠的缓存项失效, 由主机写接口自动调用
+void modbus_cache_invalidate(mb_cache_t *cache, uint8_t saddr, uint8_t fc, uint16_t addr, int nb);
+
+#endif
+
+
+
+#endif /* APPLICATIONS_MODBUS_INC_MODBUS_CACHE_H_ */
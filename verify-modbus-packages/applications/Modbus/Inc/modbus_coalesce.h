@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+#ifndef APPLICATIONS_MODBUS_INC_MODBUS_COALESCE_H_
+#define APPLICATIONS_MODBUS_INC_MODBUS_COALESCE_H_
+
+#include "modbus_instance.h"
+
+#if (defined(MB_USING_COALESCE) && defined(MB_USING_MASTER))
+
+#ifndef MB_COALESCE_GAP_DEF
+#define MB_COALESCE_GAP_DEF     8   //默认合并间隙(寄存器或位), 间隙内的数据随帧读回后丢弃
+#endif
+
+/**
+ * @brief 读请求项, pdata 按功能码解释:
+ *   - 0x01/0x02 : 输出位表(uint8_t[], 低位在前)
+ *   - 0x03/0x04 : 输出寄存器(uint16_t[])
+ */
+typedef struct{
+    uint8_t  saddr;             //从机地址
+    uint8_t  fc;                //功能码, 0x01~0x04
+    uint16_t addr;              //起始地址
+    int      nb;                //数量
+    void    *pdata;             //数据
+    int      rst;               //结果, 与同步接口一致: >0-成功(为nb), 0-超时或通信失败, <0-异常码取负
+}mb_read_item_t;
+
+//合并读取, 同从机同功能码且地址重叠或相距不超过gap的项合并为一帧(不超过单帧上限), 返回成功的项数
+int modbus_coalesce_read(mb_inst_t *hinst, mb_read_item_t *items, int num, int gap);
+
+#endif
+
+
+
+#endif /* APPLICATIONS_MODBUS_INC_MODBUS_COALESCE_H_ */
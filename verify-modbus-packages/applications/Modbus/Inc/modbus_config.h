@@ -20,6 +20,16 @@
 //#define MB_USING_ADDR_CHK         //使用从机地址检查
 //#define MB_USING_MBAP_CHK         //使用MBAP头检查
 
+#define MB_USING_EVENT_RECV         //使用事件驱动接收(阻塞等待数据到达), 注释掉则使用2ms轮询
+//#define MB_USING_RTU_T35_FRAME    //RTU按波特率计算t3.5断帧, 配置tmr硬件定时器时精度为微秒级; 无硬件定时器时字节超时仅几毫秒, 调度抖动或网关字符间隙可能使帧被拆分
+//#define MB_USING_RTU_ISR_CRC      //RTU在串口接收中断中逐字节累计CRC, 帧结束时直接得到校验结果, 需同时使用事件驱动接收; 仅串口V1生效, 其他串口框架仍由帧解析计算
+#if (defined(MB_USING_RTU_ISR_CRC) && !defined(MB_USING_EVENT_RECV))
+#error MB_USING_RTU_ISR_CRC requires MB_USING_EVENT_RECV!
+#endif
+
+//#define MB_CRC_ENGINE   4           //RTU CRC16计算引擎: 1-单表查表(缺省), 4-slicing-by-4, 8-slicing-by-8
+//#define MB_USING_CRC_BENCH        //使用CRC引擎性能测试命令(mb_crc_bench)
+
 #define MB_USING_PORT_RTT           //使用rt-thread系统接口
 //#define MB_USING_PORT_LINUX       //使用linux系统接口
 #if (defined(MB_USING_PORT_RTT) && defined(MB_USING_PORT_LINUX))
@@ -45,6 +55,15 @@
 #error MB_USING_MASTER or MB_USING_SLAVE must being defined!
 #endif
 
+//#define MB_USING_REGBANK        //使用寄存器库(声明式存储区, 从机按区表直接应答), 需同时使用从机功能
+//#define MB_USING_TCP_SERVER     //使用TCP服务器(单线程多客户端连接池), 需同时使用SOCK后端、TCP协议和从机功能
+//#define MB_USING_QUEUE          //使用主机请求队列(总线线程独占实例, 多个线程提交请求), 需同时使用主机功能
+//#define MB_USING_SCHED          //使用主机周期轮询调度器(按周期和截止时间驱动总线), 需同时使用主机功能
+//#define MB_USING_COALESCE       //使用主机合并读取(相邻读请求合并为一帧), 需同时使用主机功能
+//#define MB_USING_BUS            //使用多从机总线(一个后端多个从机上下文, 从机间轮流轮询), 需同时使用主机功能
+//#define MB_USING_CACHE          //使用主机读缓存(按数据年龄命中, 并发未命中合并, 写请求自动失效), 需同时使用主机功能
+//#define MB_USING_TCP_PIPELINE   //使用TCP主机流水线(多个在途请求, 按事务标识匹配响应), 需同时使用主机功能和TCP协议
+
 #define MB_USING_SAMPLE          //使用示例
 #ifdef MB_USING_SAMPLE
 //#define MB_USING_RTU_MASTER      //使用基于RTU后端的主机示例
@@ -11,11 +11,28 @@
 #define APPLICATIONS_MODBUS_MODBUS_CRC_H_
 
 #include "bsp_sys.h"
+#include "modbus_config.h"
 
 
+#define MB_CRC_INIT_VOL     0xFFFF
 
+#define MB_CRC_ENGINE_TABLE     1   //单表逐字节查表(512B常量表)
+#define MB_CRC_ENGINE_SLICE4    4   //slicing-by-4, 每次处理4字节(另需1.5KB RAM表)
+#define MB_CRC_ENGINE_SLICE8    8   //slicing-by-8, 每次处理8字节(另需3.5KB RAM表)
+#ifndef MB_CRC_ENGINE
+#define MB_CRC_ENGINE           MB_CRC_ENGINE_TABLE
+#endif
+#if ((MB_CRC_ENGINE != MB_CRC_ENGINE_TABLE) && (MB_CRC_ENGINE != MB_CRC_ENGINE_SLICE4) && (MB_CRC_ENGINE != MB_CRC_ENGINE_SLICE8))
+#error MB_CRC_ENGINE must be 1, 4 or 8!
+#endif
 
-#define MB_CRC_INIT_VOL     0xFFFF
+extern const uint16_t modbus_crc_table[256];
+
+//逐字节更新CRC, 可在串口接收中断中调用, 帧结束时CRC即已算好
+static inline uint16_t modbus_crc_byte_update(uint16_t crc, uint8_t byte)
+{
+    return((crc >> 8) ^ modbus_crc_table[(uint8_t)(crc ^ byte)]);
+}
 
 uint16_t modbus_crc_cyc_cal(uint16_t init, const uint8_t *pdata, int len);
 uint16_t modbus_crc_cal(const uint8_t *pdata, int len) ;
@@ -13,6 +13,7 @@
 
 #include "modbus_rtu.h"
 #include "modbus_backend.h"
+#include "modbus_regbank.h"
 
 
 #ifdef MB_USING_RAW_PRT
@@ -20,7 +21,7 @@
  * @brief 调试用：打印 Modbus 原始数据帧
  * @see modbus_raw_printf 实现细节
  */
-void modbus_raw_printf(bool is_send, const u8 *pdata, int dlen);
+void modbus_raw_printf(int is_send, const uint8_t *pdata, int dlen);
 #endif
 
 
@@ -45,6 +46,8 @@ typedef int (*modbus_write_bit_t)(uint16_t addr, uint8_t bit);//写bit位, 返
 typedef int (*modbus_read_reg_t)(uint16_t addr, uint16_t *pval);//读16位寄存器, 返回 : 0-成功, -2-地址错误
 typedef int (*modbus_write_reg_t)(uint16_t addr, uint16_t val);//写16位寄存器, 返回 : 0-成功, -2-地址错误, -3-值非法, -4-设备故障
 typedef int (*modbus_mask_write_t)(uint16_t addr, uint16_t mask_and, uint16_t mask_or);//屏蔽写寄存器, 返回 : 0-成功, -2-地址错误, -3-值非法, -4-设备故障
+typedef int (*modbus_read_regs_t)(uint16_t addr, int nb, uint16_t *pregs);//读连续nb个16位寄存器(主机序), 返回 : 0-成功, -2-地址错误
+typedef int (*modbus_write_regs_t)(uint16_t addr, int nb, const uint16_t *pregs);//写连续nb个16位寄存器(主机序), 返回 : 0-成功, -2-地址错误, -3-值非法, -4-设备故障
 
 
 /**
@@ -57,6 +60,9 @@ typedef struct{
     modbus_read_reg_t   read_input; //读输入寄存器
     modbus_read_reg_t   read_hold;  //读保持寄存器
     modbus_write_reg_t  write_hold; //写保持寄存器
+    modbus_read_regs_t  read_input_range;   //批量读输入寄存器, 非NULL时优先于read_input
+    modbus_read_regs_t  read_hold_range;    //批量读保持寄存器, 非NULL时优先于read_hold
+    modbus_write_regs_t write_hold_range;   //批量写保持寄存器, 非NULL时优先于write_hold
 }mb_cb_table_t;
 
 
@@ -70,16 +76,25 @@ typedef struct{
     rt_uint16_t tsid;           // TCP传输标识计数
     mb_backend_t *backend;      // 后端指针
     mb_cb_table_t *cb;          // 从机回调函数表
-    uint8_t datas[256];         // 读写数据缓冲区
+    #ifdef MB_USING_REGBANK
+    const mb_regbank_t *bank;   // 从机寄存器库, 非NULL时优先于回调函数表
+    #endif
+    #if (defined(MB_USING_CACHE) && defined(MB_USING_MASTER))
+    struct mb_cache *cache;     // 主机读缓存, 非NULL时写请求完成后使缓存中对应区间失效
+    #endif
+    #ifdef MB_USING_RTU_ISR_CRC
+    int rx_crc;                 // 最近一帧在接收中断中累计的CRC校验结果: 1-正确, 0-错误, -1-未知
+    #endif
+    rt_align(4) uint8_t datas[256]; // 读写数据缓冲区, 4字节对齐, 批量回调直接作为uint16_t数组使用
     uint8_t buf[MB_BUF_SIZE];   // 收发缓冲区
 }mb_inst_t;
 
 //创建modbus实例, 成功返回实例指针, 失败返回NULL
 mb_inst_t * modbus_create(mb_backend_type_t type, const mb_backend_param_t *param);
 //销毁modbus实例
-void modbus_destory(mb_inst_t *hinst);
+void modbus_destroy(mb_inst_t *hinst);
 //修改从机地址, 默认地址为1
-void modbus_set_slave(mb_inst_t *hinst, uint8_t saddr);
+void modbus_set_slave_addr(mb_inst_t *hinst, uint8_t saddr);
 //修改协议, 默认使用与后端类型一致的协议类型
 void modbus_set_prot(mb_inst_t *hinst, mb_prot_t prot);
 //修改超时时间, 默认应答超时300ms, 字节超时32ms
@@ -90,12 +105,34 @@ int modbus_connect(mb_inst_t *hinst);
 int modbus_disconn(mb_inst_t *hinst);
 //接收数据, 返回收到数据长度, 超时返回0, 错误返回-1, 发生错误时会自动关闭后端
 int modbus_recv(mb_inst_t *hinst, uint8_t *buf, int bufsize);
+//接收一帧数据, 按功能码预测帧长度, 收完整帧立即返回, 返回值同modbus_recv
+int modbus_recv_frame(mb_inst_t *hinst, uint8_t *buf, int bufsize, mb_pdu_type_t type);
+//接收一帧数据, 本次应答超时为tmo_ms(不修改实例配置), 返回值同modbus_recv
+int modbus_recv_frame_tmo(mb_inst_t *hinst, uint8_t *buf, int bufsize, mb_pdu_type_t type, int tmo_ms);
+//最近一帧的CRC校验结果: 1-正确, 0-错误, -1-未知(由帧解析计算), 作为modbus_rtu_frame_parse_crc的参数
+static inline int modbus_rx_crc(const mb_inst_t *hinst)
+{
+    #ifdef MB_USING_RTU_ISR_CRC
+    return(hinst->rx_crc);
+    #else
+    return(-1);
+    #endif
+}
 //发送数据, 返回发送数据长度, 错误返回-1, 发生错误时会自动关闭后端
 int modbus_send(mb_inst_t *hinst, uint8_t *buf, int size);
 //清空接收缓存, 成功返回0, 失败返回-1
 int modbus_flush(mb_inst_t *hinst);
+//丢弃接收数据直到总线静默silence_ms(<=0使用字节超时), 用于RTU冲突后重新对齐帧边界, 返回丢弃字节数, 失败返回-1
+int modbus_discard(mb_inst_t *hinst, int silence_ms);
+//零拷贝编码: 返回收发缓冲区中PDU的起始位置(已预留从机地址或MBAP头), 调用者直接写入PDU
+uint8_t *modbus_frame_pdu(mb_inst_t *hinst);
+//零拷贝编码: 封装已写入的请求PDU(RTU填写地址并原地追加CRC, TCP分配事务标识并填写MBAP头), 返回帧长度
+int modbus_frame_seal(mb_inst_t *hinst, int pdu_len);
 
 #ifdef MB_USING_MASTER
+#ifndef MB_RANGE_PIPE_WIN
+#define MB_RANGE_PIPE_WIN   4   //TCP协议下大范围读写的流水线窗口, 1为逐块同步执行
+#endif
 //读请求, 功能码和数据由用户确定, 成功返回应答数据长度, 异常应答返回负值错误码, 其它错误返回0
 int modbus_read_req(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, uint8_t *pdata);
 //写请求, 功能码和数据由用户确定, 成功返回请求数量, 异常应答返回负值错误码, 其它错误返回0
@@ -120,13 +157,27 @@ int modbus_write_regs(mb_inst_t *hinst, uint16_t addr, int nb, const uint16_t *p
 int modbus_mask_write_reg(mb_inst_t *hinst, uint16_t addr, uint16_t mask_and, uint16_t mask_or);
 //读/写多个保持寄存器, 功能码-0x17, 成功返回读取寄存器数量, 异常应答返回负值错误码, 其它错误返回0
 int modbus_write_and_read_regs(mb_inst_t *hinst, uint16_t wr_addr, int wr_nb, const uint16_t *p_wr_regs,uint16_t rd_addr, int rd_nb, uint16_t *p_rd_regs);
+//大范围读取(0x01~0x04), 数量不受单帧上限限制, 自动分块(TCP协议下流水线), 成功返回nb, 异常应答返回负值错误码, 其它错误返回0
+int modbus_read_range(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, void *pdata);
+//大范围写入(0x0F/0x10), 返回值同modbus_read_range
+int modbus_write_range(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, const void *pdata);
+//按功能码执行一次请求(0x01~0x06, 0x0F, 0x10), 先切换到从机saddr, 返回值同对应接口
+int modbus_master_call(mb_inst_t *hinst, uint8_t saddr, uint8_t fc, uint16_t addr, int nb, void *pdata);
 #endif
 
 #ifdef MB_USING_SLAVE
+//缺省从机回调函数表(modbus_port中接口函数), 可复制后修改部分回调
+extern const mb_cb_table_t mb_cb_table;
 //修改从机回调函数表, 默认使用modbus_port中接口函数做回调函数
 void modbus_set_cb_table(mb_inst_t *hinst, const mb_cb_table_t *cb);
+#ifdef MB_USING_REGBANK
+//设置寄存器库, 设置后从机直接按区表应答请求, 不再调用回调函数表, NULL恢复使用回调函数表
+void modbus_set_regbank(mb_inst_t *hinst, const mb_regbank_t *bank);
+#endif
 //从机状态机处理, 在线程中循环调用即可
 void modbus_slave_fsm(mb_inst_t *hinst);
+//处理已到达的请求(含重组缓冲区中的后续请求), 返回处理的请求数, 连接断开返回-1
+int modbus_slave_poll(mb_inst_t *hinst);
 #endif
 
 
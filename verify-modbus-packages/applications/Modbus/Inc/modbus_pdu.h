@@ -127,8 +127,30 @@ typedef union{
     mb_pdu_wr_rd_req_t  wr_rd_req;  //写然后读请求
 }mb_pdu_t;//PDU数据联合体定义
 
+#define MB_PDU_FC_TAB_SIZE                  (MODBUS_FC_WRITE_AND_READ_REGISTERS + 1)    //功能码描述表大小(最大支持功能码+1)
+
+typedef struct{
+    uint8_t hlen;           //固定头部长度(含功能码, 带数据时含字节计数)
+    uint8_t nw;             //功能码之后的16位字段个数
+    uint8_t w_off[4];       //各16位字段在PDU结构体中的偏移
+    uint8_t dlen_off;       //字节计数字段在PDU结构体中的偏移, 0表示无字节计数及数据
+    uint8_t pdata_off;      //数据指针在PDU结构体中的偏移
+}mb_pdu_fmt_t;//PDU格式: 功能码 + nw个16位字段 + [字节计数 + 数据]
+
+typedef struct{
+    const mb_pdu_fmt_t *req;    //请求格式, NULL表示功能码不支持
+    const mb_pdu_fmt_t *rsp;    //响应格式
+    uint8_t bits;               //数量单位: 1-位(字节计数为(nb+7)/8), 0-寄存器(字节计数为nb*2)
+    uint16_t rd_max;            //读数量上限, 0表示无读数量
+    uint16_t wr_max;            //写数量上限, 0表示无写数量
+}mb_pdu_desc_t;//功能码描述
+
+const mb_pdu_desc_t *modbus_pdu_desc(uint8_t fc);//查找功能码描述, 不支持返回NULL
+int modbus_pdu_data_len(uint8_t fc, int nb);//nb个数量对应的数据字节数(位为(nb+7)/8, 寄存器为nb*2), 不支持返回0
+int modbus_pdu_check(const mb_pdu_t *pdu);//从站请求合法性检查(数量上限、字节计数、地址范围), 合法返回0, 否则返回应答的异常码
 int modbus_pdu_make(uint8_t *buf, const mb_pdu_t *pdu, mb_pdu_type_t type);//生成pdu帧, 返回帧长度, 失败返回0
 int modbus_pdu_parse(const uint8_t *buf, int len, mb_pdu_t *pdu, mb_pdu_type_t type);//解析pdu帧, 成功返回帧长度, 帧错误返回0, 功能码不支持返回-1
+int modbus_pdu_frame_len(const uint8_t *buf, int len, mb_pdu_type_t type);//预测完整pdu长度, 数据不足返回0, 功能码不支持返回-1
 
 
 
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+#ifndef APPLICATIONS_MODBUS_INC_MODBUS_QUEUE_H_
+#define APPLICATIONS_MODBUS_INC_MODBUS_QUEUE_H_
+
+#include "modbus_instance.h"
+
+#if (defined(MB_USING_QUEUE) && defined(MB_USING_MASTER))
+
+#include <rtdevice.h>
+
+#define MB_QUEUE_PRIO_HIGH      0   //高优先级, 插到队首(多个高优先级请求之间后进先出)
+#define MB_QUEUE_PRIO_NORMAL    1   //普通优先级, 按提交顺序处理
+
+typedef struct mb_queue_req mb_queue_req_t;
+
+/**
+ * @brief 请求完成回调, 在总线线程中调用, 不要在回调中阻塞
+ * @param req 已完成的请求, req->rst 为结果
+ */
+typedef void (*modbus_queue_cb_t)(mb_queue_req_t *req);
+
+/**
+ * @brief 请求描述, 由提交者分配, 完成(回调或同步返回)前须保持有效
+ *
+ * pdata 按功能码解释:
+ *   - 0x01/0x02 : 输出位表(uint8_t[], 低位在前)
+ *   - 0x03/0x04 : 输出寄存器(uint16_t[])
+ *   - 0x05      : 输入位值(uint8_t *)
+ *   - 0x06      : 输入寄存器值(uint16_t *)
+ *   - 0x0F      : 输入位表(uint8_t[])
+ *   - 0x10      : 输入寄存器(uint16_t[])
+ */
+struct mb_queue_req{
+    uint8_t  saddr;             //从机地址
+    uint8_t  fc;                //功能码
+    uint16_t addr;              //起始地址
+    int      nb;                //数量
+    void    *pdata;             //数据
+    int      rst;               //结果, 与同步接口一致: >0-成功, 0-超时或通信失败, <0-异常码取负
+    modbus_queue_cb_t cb;       //完成回调, 可为NULL
+    void    *arg;               //回调参数
+    struct rt_completion *done; //完成通知, 可为NULL
+};
+
+typedef struct{
+    mb_inst_t *hinst;           //所属实例, 创建后只由总线线程访问
+    rt_mq_t mq;                 //请求队列, 消息为请求指针
+    rt_thread_t tid;            //总线线程
+    struct rt_completion exit;  //总线线程退出通知
+    volatile int run;           //运行标志
+    uint32_t done_cnt;          //已完成请求数
+}mb_queue_t;//主机请求队列
+
+//创建请求队列和总线线程, depth为队列深度, 成功返回指针, 失败返回NULL
+mb_queue_t *modbus_queue_create(mb_inst_t *hinst, int depth, int stack_size, int prio);
+//销毁请求队列, 队列中未处理的请求以结果0完成, 实例不销毁
+void modbus_queue_destroy(mb_queue_t *q);
+//异步提交请求, prio为MB_QUEUE_PRIO_HIGH或MB_QUEUE_PRIO_NORMAL, 成功返回0, 队列满或参数错误返回-1
+int modbus_queue_submit(mb_queue_t *q, mb_queue_req_t *req, int prio);
+//同步提交请求并等待完成(每个请求最长为实例的应答超时), 返回req->rst, 提交失败返回0
+int modbus_queue_call(mb_queue_t *q, mb_queue_req_t *req, int prio);
+
+#endif
+
+
+
+#endif /* APPLICATIONS_MODBUS_INC_MODBUS_QUEUE_H_ */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+#ifndef APPLICATIONS_MODBUS_INC_MODBUS_REGBANK_H_
+#define APPLICATIONS_MODBUS_INC_MODBUS_REGBANK_H_
+
+#include "modbus_config.h"
+#include <stdint.h>
+
+#ifdef MB_USING_REGBANK
+
+/**
+ * 寄存器区类型
+ */
+typedef enum{
+    MB_REG_TYPE_COIL = 0,   //线圈, 功能码 0x01/0x05/0x0F
+    MB_REG_TYPE_DISC,       //离散量输入, 功能码 0x02
+    MB_REG_TYPE_INPUT,      //输入寄存器, 功能码 0x04
+    MB_REG_TYPE_HOLD,       //保持寄存器, 功能码 0x03/0x06/0x10/0x16/0x17
+    MB_REG_TYPE_MAX
+}mb_reg_type_t;
+
+/**
+ * 写入钩子, 在数据写入存储区之前调用
+ * pdata为请求中的原始数据: 寄存器为大端序字节流, 位为低位在前的位表(从bit0开始)
+ * 返回 : 0-允许写入, -3-值非法, -4-设备故障(拒绝写入, 以对应异常码应答)
+ */
+typedef int (*modbus_reg_hook_t)(uint16_t addr, int nb, const uint8_t *pdata);
+
+typedef struct{
+    mb_reg_type_t type;         //区类型
+    uint16_t base;              //起始地址
+    uint16_t count;             //数量(位或寄存器)
+    void *ptr;                  //存储区: 位为低位在前的位表(uint8_t[]), 寄存器为主机序数组(uint16_t[])
+    modbus_reg_hook_t on_write; //写入钩子, 可为NULL, 仅线圈和保持寄存器有效
+}mb_reg_region_t;//寄存器区
+
+typedef struct{
+    mb_reg_region_t *regions;   //区表, 按(类型, 起始地址)排序
+    int num;                    //区数量
+}mb_regbank_t;//寄存器库
+
+//初始化寄存器库, 区表按类型和地址原地排序, 同类型区重叠返回-1, 成功返回0
+int modbus_regbank_init(mb_regbank_t *bank, mb_reg_region_t *regions, int num);
+//查找完整包含[addr, addr+nb)的区, 未找到返回NULL
+const mb_reg_region_t *modbus_regbank_find(const mb_regbank_t *bank, mb_reg_type_t type, uint16_t addr, int nb);
+//读取数据到pdata(寄存器为大端序, 位为低位在前位表), 返回 : 0-成功, -2-地址错误
+int modbus_regbank_read(const mb_regbank_t *bank, mb_reg_type_t type, uint16_t addr, int nb, uint8_t *pdata);
+//将pdata(格式同上)写入存储区, 返回 : 0-成功, -2-地址错误, 其它为写入钩子返回值
+int modbus_regbank_write(const mb_regbank_t *bank, mb_reg_type_t type, uint16_t addr, int nb, const uint8_t *pdata);
+
+#endif
+
+
+
+#endif /* APPLICATIONS_MODBUS_INC_MODBUS_REGBANK_H_ */
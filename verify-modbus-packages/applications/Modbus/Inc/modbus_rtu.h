@@ -29,7 +29,10 @@ typedef struct{
 }mb_rtu_frm_t;//RTU帧定义
 
 int modbus_rtu_frame_make(uint8_t *buf, const mb_rtu_frm_t *frm, mb_pdu_type_t type);
+int modbus_rtu_frame_seal(uint8_t *buf, uint8_t saddr, int pdu_len);//PDU已写入buf+MB_RTU_SADDR_SIZE处, 填写从机地址并原地追加CRC, 返回帧长度
 int modbus_rtu_frame_parse(const uint8_t *buf, int len, mb_rtu_frm_t *frm, mb_pdu_type_t type);
+int modbus_rtu_frame_parse_crc(const uint8_t *buf, int len, mb_rtu_frm_t *frm, mb_pdu_type_t type, int crc_ok);//crc_ok为接收中断中已得到的校验结果, -1时计算CRC
+int modbus_rtu_frame_len(const uint8_t *buf, int len, int type);//预测完整rtu帧长度, 数据不足返回0, 功能码不支持返回-1
 
 
 #endif /* APPLICATIONS_MODBUS_RTU_H_ */
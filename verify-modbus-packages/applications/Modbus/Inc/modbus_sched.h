@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+#ifndef APPLICATIONS_MODBUS_INC_MODBUS_SCHED_H_
+#define APPLICATIONS_MODBUS_INC_MODBUS_SCHED_H_
+
+#include "modbus_instance.h"
+
+#if (defined(MB_USING_SCHED) && defined(MB_USING_MASTER))
+
+typedef struct mb_poll mb_poll_t;
+
+/**
+ * @brief 轮询完成回调, 在调度线程中调用, 不要在回调中阻塞
+ * @param pt  已执行的轮询点
+ * @param rst 结果, 与同步接口一致: >0-成功, 0-超时或通信失败, <0-异常码取负
+ */
+typedef void (*modbus_poll_cb_t)(mb_poll_t *pt, int rst);
+
+/**
+ * @brief 轮询点, 由应用静态定义成表, pdata 按功能码解释(同 modbus_master_call)
+ */
+struct mb_poll{
+    //配置
+    uint8_t  saddr;             //从机地址
+    uint8_t  fc;                //功能码
+    uint16_t addr;              //起始地址
+    int      nb;                //数量
+    int      period_ms;         //周期(毫秒), 截止时间为释放时间加一个周期
+    int      prio;              //优先级, 截止时间相同时数值小者先执行
+    void    *pdata;             //数据
+    modbus_poll_cb_t cb;        //完成回调, 可为NULL
+    void    *arg;               //回调参数
+
+    //运行状态和统计, 由调度器维护
+    long long next_ms;          //下次释放时间
+    long long last_ms;          //上次开始执行时间
+    uint32_t run_cnt;           //执行次数
+    uint32_t miss_cnt;          //错过截止时间次数(含过载时跳过的释放)
+    uint32_t err_cnt;           //失败次数(超时或异常应答)
+    int      cycle_ms;          //最近一次实际周期(相邻两次开始执行的间隔)
+    int      cycle_max_ms;      //最大实际周期
+    int      cost_ms;           //最近一次执行耗时
+    int      cost_max_ms;       //最大执行耗时
+};
+
+typedef struct{
+    mb_inst_t *hinst;           //所属实例, 只由调度线程访问
+    mb_poll_t *table;           //轮询点表
+    int num;                    //轮询点数量
+    long long start_ms;         //统计起始时间
+    long long busy_ms;          //总线占用累计时间
+}mb_sched_t;//主机周期轮询调度器
+
+//初始化调度器, 全部轮询点立即释放并清除统计, 参数错误返回-1, 成功返回0
+int modbus_sched_init(mb_sched_t *s, mb_inst_t *hinst, mb_poll_t *table, int num);
+//调度处理, 执行一个截止时间最早的已释放轮询点, 无可执行点时最多等待tmo_ms, 返回执行结果, 未执行返回0
+int modbus_sched_poll(mb_sched_t *s, int tmo_ms);
+//清除统计
+void modbus_sched_reset_stat(mb_sched_t *s);
+//打印每个轮询点的周期、耗时、错过截止时间次数和总线占用率
+void modbus_sched_dump(const mb_sched_t *s);
+
+#endif
+
+
+
+#endif /* APPLICATIONS_MODBUS_INC_MODBUS_SCHED_H_ */
@@ -33,7 +33,9 @@ typedef struct{
 }mb_tcp_frm_t;//TCP帧定义
 
 int modbus_tcp_frm_make(uint8_t *buf, const mb_tcp_frm_t *frm, mb_pdu_type_t type);//生成tcp帧, 返回帧长度
+int modbus_tcp_frm_seal(uint8_t *buf, const mb_tcp_mbap_t *mbap, int pdu_len);//PDU已写入buf+MB_TCP_MBAP_SIZE处, 填写MBAP头, 返回帧长度
 int modbus_tcp_frm_parse(const uint8_t *buf, int len, mb_tcp_frm_t *frm, mb_pdu_type_t type);//解析tcp帧, 返回pdu数据长度, 解析失败返回0, 功能码不支持返回-1
+int modbus_tcp_frm_len(const uint8_t *buf, int len, int type);//由MBAP长度字段得出完整tcp帧长度, 数据不足返回0, 长度非法返回-1
 
 #endif
 
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+#ifndef APPLICATIONS_MODBUS_INC_MODBUS_TCP_PIPE_H_
+#define APPLICATIONS_MODBUS_INC_MODBUS_TCP_PIPE_H_
+
+#include "modbus_instance.h"
+
+#if (defined(MB_USING_TCP_PIPELINE) && defined(MB_USING_MASTER) && defined(MB_USING_TCP_PROTOCOL))
+
+#ifndef MB_PIPE_WIN_MAX
+#define MB_PIPE_WIN_MAX     16  //流水线最大并发事务数
+#endif
+
+/**
+ * @brief 事务完成回调
+ * @param arg   提交时传入的用户参数
+ * @param rst   结果, 与同步接口一致: >0-成功(读: 数据字节数, 写多个: 写入数量, 写单个: 1), 0-超时或通信失败, <0-异常码取负
+ * @param pdata 读响应数据(大端字节流), 仅在回调内有效, 写操作为NULL
+ * @param dlen  读响应数据长度
+ */
+typedef void (*modbus_pipe_cb_t)(void *arg, int rst, const uint8_t *pdata, int dlen);
+
+typedef struct{
+    uint8_t  used;      //占用标志
+    uint8_t  fc;        //请求功能码
+    uint16_t tid;       //事务标识
+    uint16_t nb;        //请求数量, 用于校验读响应的字节计数
+    long long tx_ms;    //发送时间
+    modbus_pipe_cb_t cb;//完成回调
+    void *arg;          //回调参数
+}mb_pipe_slot_t;//在途事务
+
+typedef struct{
+    mb_inst_t *hinst;                       //所属实例(须为TCP协议)
+    int win;                                //窗口大小, 最大在途事务数
+    int pending;                            //当前在途事务数
+    mb_pipe_slot_t slot[MB_PIPE_WIN_MAX];   //在途事务表
+}mb_pipe_t;//TCP主机流水线
+
+//创建流水线, win为窗口大小(1~MB_PIPE_WIN_MAX), 成功返回指针, 失败返回NULL
+mb_pipe_t *modbus_pipe_create(mb_inst_t *hinst, int win);
+//销毁流水线, 未完成事务以结果0回调
+void modbus_pipe_destroy(mb_pipe_t *pipe);
+//提交读请求(0x01~0x04), 窗口满时先接收响应腾出空位, 成功返回事务标识(>=0), 功能码非法或失败返回-1(发送失败时全部在途事务以结果0完成)
+int modbus_pipe_read_req(mb_pipe_t *pipe, uint8_t func, uint16_t addr, int nb, modbus_pipe_cb_t cb, void *arg);
+//提交写多个请求(0x0F/0x10), 返回值同modbus_pipe_read_req
+int modbus_pipe_write_req(mb_pipe_t *pipe, uint8_t func, uint16_t addr, int nb, const uint8_t *pdata, int dlen, modbus_pipe_cb_t cb, void *arg);
+//提交写单个请求(0x05/0x06), 返回值同modbus_pipe_read_req
+int modbus_pipe_write_single(mb_pipe_t *pipe, uint8_t func, uint16_t addr, uint16_t val, modbus_pipe_cb_t cb, void *arg);
+//接收并分发响应, 最多等待tmo_ms, 返回本次完成的事务数, 错误返回-1
+int modbus_pipe_poll(mb_pipe_t *pipe, int tmo_ms);
+//等待全部在途事务完成(成功、异常或超时), 返回完成的事务数, 错误返回-1
+int modbus_pipe_wait_all(mb_pipe_t *pipe);
+
+#endif
+
+
+
+#endif /* APPLICATIONS_MODBUS_INC_MODBUS_TCP_PIPE_H_ */
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+#ifndef APPLICATIONS_MODBUS_INC_MODBUS_TCP_SRV_H_
+#define APPLICATIONS_MODBUS_INC_MODBUS_TCP_SRV_H_
+
+#include "modbus_instance.h"
+
+#if (defined(MB_USING_TCP_SERVER) && defined(MB_USING_SOCK_BACKEND) && defined(MB_USING_TCP_PROTOCOL) && defined(MB_USING_SLAVE))
+
+#ifndef MB_TCP_SRV_CONN_MAX
+#ifdef SAL_SOCKETS_NUM
+#define MB_TCP_SRV_CONN_MAX     (SAL_SOCKETS_NUM - 1)   //最大客户端连接数, 预留一个给监听socket
+#else
+#define MB_TCP_SRV_CONN_MAX     8
+#endif
+#endif
+
+#ifndef MB_TCP_SRV_SND_TMO_MS
+#define MB_TCP_SRV_SND_TMO_MS   100     //应答发送超时(毫秒), 客户端不读取导致发送窗口满时到时断开该连接, 不阻塞其它客户端
+#endif
+
+typedef struct{
+    int lfd;                                //监听socket, <0 表示未建立
+    uint16_t port;                          //监听端口
+    int max_conn;                           //最大连接数
+    int conn_cnt;                           //当前连接数
+    uint8_t saddr;                          //从机地址(单元标识)
+    const mb_cb_table_t *cb;                //全部连接共享的回调函数表(寄存器映射)
+    int fd[MB_TCP_SRV_CONN_MAX];            //客户端socket
+    mb_inst_t *conn[MB_TCP_SRV_CONN_MAX];   //客户端实例, NULL 表示空闲
+}mb_tcp_srv_t;//Modbus TCP服务器
+
+//创建服务器, max_conn<=0 或超过上限时使用MB_TCP_SRV_CONN_MAX, 成功返回指针, 失败返回NULL
+mb_tcp_srv_t *modbus_tcp_srv_create(uint16_t port, int max_conn);
+//销毁服务器, 关闭全部连接和监听socket
+void modbus_tcp_srv_destroy(mb_tcp_srv_t *srv);
+//修改共享回调函数表, 默认使用modbus_port中接口函数做回调函数
+void modbus_tcp_srv_set_cb_table(mb_tcp_srv_t *srv, const mb_cb_table_t *cb);
+//修改从机地址, 默认地址为1
+void modbus_tcp_srv_set_slave(mb_tcp_srv_t *srv, uint8_t saddr);
+//服务器处理, 最多等待tmo_ms, 在线程中循环调用即可, 返回处理的请求数, 错误返回-1
+int modbus_tcp_srv_poll(mb_tcp_srv_t *srv, int tmo_ms);
+
+#endif
+
+
+
+#endif /* APPLICATIONS_MODBUS_INC_MODBUS_TCP_SRV_H_ */
@@ -59,11 +59,308 @@ MB_WEAK void modbus_port_delay_ms(int tmo_ms)
 
 
 
+/**
+ * @brief RTU 端口实例结构体
+ *
+ * 由 modbus_port_rtu_open() 分配，作为 RTU 后端的底层句柄（hinst）。
+ * 同时挂在串口设备的 user_data 上，供接收回调（中断上下文）找回实例。
+ */
+#if (defined(RT_SERIAL_USING_DMA) && defined(MB_USING_EVENT_RECV))
+#define MB_PORT_RTU_USING_DMA       // 支持 DMA 收发(发送完成由事件通知)
+#endif
+
+#if (defined(USART_CR3_DEM) && defined(RT_USING_SERIAL_V1))
+#include "drv_usart.h"
+#define MB_PORT_RTU_USING_HW_DE     // 支持 USART 硬件 DE(STM32F0/F3/F7/L4/G4/H7 等, F4 无此功能)
+#endif
+
+#if (defined(MB_USING_RTU_ISR_CRC) && defined(RT_USING_SERIAL_V1))
+#define MB_PORT_RTU_USING_ISR_CRC   // 接收中断中累计 CRC(依赖串口 V1 的 rt_serial_rx_fifo, 其他串口框架由帧解析计算)
+#endif
+
+/**
+ * @brief RS485 收发控制（DE）配置
+ */
+typedef struct{
+    int pin;                    // DE 引脚, <0 表示不使用
+    int lvl;                    // 发送控制电平
+    int mode;                   // 控制方式, MB_RTU_DE_SOFT/MB_RTU_DE_TC/MB_RTU_DE_HW
+}mb_port_rtu_de_t;
+
+typedef struct{
+    rt_device_t dev;            // 串口设备
+    mb_port_rtu_de_t de;        // RS485 DE 控制
+    #ifdef MB_USING_EVENT_RECV
+    struct rt_event evt;        // 接收事件
+    #endif
+    #ifdef MB_USING_RTU_T35_FRAME
+    int t35_us;                 // 帧间隔 t3.5（微秒）
+    rt_device_t tmr;            // t3.5 硬件定时器, NULL 表示不使用
+    volatile rt_uint32_t rx_seq;    // 接收回调计数, 每批新数据加 1
+    volatile rt_uint32_t eof_seq;   // 发出帧结束事件时的 rx_seq
+    #endif
+    #ifdef MB_PORT_RTU_USING_DMA
+    int dma_tx;                 // 使用 DMA 发送
+    int char_us;                // 单字符时间（微秒）
+    #endif
+    #ifdef MB_PORT_RTU_USING_ISR_CRC
+    uint16_t crc;               // 接收中断中累计的 CRC
+    int crc_cnt;                // 已累计的字节数
+    rt_uint16_t crc_idx;        // 串口接收 fifo 中下一个待累计字节的位置
+    #endif
+}mb_port_rtu_t;
+
+#define MB_PORT_EVT_RX      (1 << 0)    // 收到数据事件
+#define MB_PORT_EVT_EOF     (1 << 1)    // 帧结束事件（t3.5 静默）
+#define MB_PORT_EVT_TX      (1 << 2)    // DMA 发送完成事件
+
+
+#if (defined(MB_USING_RTU_T35_FRAME) && defined(MB_USING_EVENT_RECV) && defined(RT_USING_HWTIMER))
+#define MB_PORT_RTU_USING_TMR       // 使用硬件定时器检测 t3.5
+#endif
+
+
+/**
+ * @brief  计算 RTU 帧间隔 t3.5（微秒）
+ *
+ * 按 1 起始位 + 8 数据位 + 校验/停止共 11 位计算单字符时间。
+ * 波特率大于 19200 时按规范使用固定值 1750us。
+ *
+ * @param[in] baudrate  波特率
+ *
+ * @return int  t3.5 微秒数（如 9600 波特率约 4010us）
+ */
+int modbus_rtu_t35_us(int baudrate)
+{
+    if ((baudrate <= 0) || (baudrate > 19200)){
+        return(1750);
+    }
+    return((int)((35LL * MB_RTU_CHAR_BITS * 1000000) / (10LL * baudrate)));
+}
+
+
+#ifdef MB_USING_EVENT_RECV
+#ifdef MB_PORT_RTU_USING_ISR_CRC
+/**
+ * @brief  将串口接收 fifo 中新到达的字节累计到 CRC（须在关中断或中断上下文中调用）
+ *
+ * 只读取 fifo 中的数据，不移动读位置，数据仍由 modbus_port_rtu_read() 取走。
+ * 串口 V1 的中断接收和 DMA 接收都以 rt_serial_rx_fifo 作为接收缓冲区。
+ */
+static void modbus_port_rtu_crc_fold(mb_port_rtu_t *port)
+{
+    struct rt_serial_device *serial = (struct rt_serial_device *)port->dev;
+    struct rt_serial_rx_fifo *fifo = (struct rt_serial_rx_fifo *)serial->serial_rx;
+    if (fifo == RT_NULL){
+        return;
+    }
+    rt_uint16_t bufsz = serial->config.bufsz;
+    rt_uint16_t idx = port->crc_idx;
+    uint16_t crc = port->crc;
+    int cnt = port->crc_cnt;
+    while (idx != fifo->put_index){
+        crc = modbus_crc_byte_update(crc, fifo->buffer[idx]);
+        idx = (idx + 1 < bufsz) ? (idx + 1) : 0;
+        cnt++;
+    }
+    port->crc_idx = idx;
+    port->crc = crc;
+    port->crc_cnt = cnt;
+}
+
+
+/**
+ * @brief  接收中断 CRC 累计控制
+ *
+ * @param[in] hinst  端口实例
+ * @param[in] len    0: 从 fifo 当前读位置重新开始累计（开始接收新帧时调用）
+ *                   >0: 查询刚读出的 len 字节的校验结果
+ *
+ * @return int
+ *   -  1 : 累计字节数正好为 len 且余数为 0（含 CRC 的整帧校验正确）
+ *   -  0 : 累计字节数正好为 len 但余数不为 0（校验错误）
+ *   - -1 : 无法判断（fifo 溢出或 len 后还有数据），由帧解析重新计算
+ */
+static int modbus_port_rtu_rx_crc(void *hinst, int len)
+{
+    MB_ASSERT(hinst != NULL);
+
+    mb_port_rtu_t *port = (mb_port_rtu_t *)hinst;
+    struct rt_serial_device *serial = (struct rt_serial_device *)port->dev;
+    struct rt_serial_rx_fifo *fifo = (struct rt_serial_rx_fifo *)serial->serial_rx;
+    if (fifo == RT_NULL){
+        return(-1);
+    }
+
+    int rst = 0;
+    rt_base_t level = rt_hw_interrupt_disable();
+    if (len == 0){
+        port->crc = MB_CRC_INIT_VOL;
+        port->crc_cnt = 0;
+        port->crc_idx = fifo->get_index;
+        modbus_port_rtu_crc_fold(port);//已在 fifo 中的数据立即累计
+    }
+    else if (fifo->is_full || (port->crc_cnt != len)){
+        rst = -1;
+    }
+    else{
+        rst = (port->crc == 0) ? 1 : 0;
+    }
+    rt_hw_interrupt_enable(level);
+
+    return(rst);
+}
+#endif
+
+
+/**
+ * @brief  串口接收指示回调（中断上下文）
+ *
+ * 串口每收到一批数据由驱动调用，仅发送接收事件唤醒等待线程，不读取数据。
+ * 启用 MB_USING_RTU_ISR_CRC（串口 V1）时同时把新到达的字节累计到 CRC，帧结束时无需再遍历整帧。
+ *
+ * @param[in] dev   串口设备
+ * @param[in] size  当前可读数据长度
+ *
+ * @return RT_EOK
+ */
+static rt_err_t modbus_port_rtu_rx_ind(rt_device_t dev, rt_size_t size)
+{
+    mb_port_rtu_t *port = (mb_port_rtu_t *)dev->user_data;
+    if (port != NULL){
+        #ifdef MB_PORT_RTU_USING_ISR_CRC
+        modbus_port_rtu_crc_fold(port);
+        #endif
+        #ifdef MB_PORT_RTU_USING_TMR
+        if (port->tmr != NULL){
+            // 新数据到达, 之前的帧结束事件作废(由等待线程按 rx_seq 判断), 重新开始 t3.5 计时
+            port->rx_seq++;
+            rt_hwtimerval_t tv = {0, port->t35_us};
+            rt_device_write(port->tmr, 0, &tv, sizeof(tv));
+        }
+        #endif
+        rt_event_send(&(port->evt), MB_PORT_EVT_RX);
+    }
+    return(RT_EOK);
+}
+#endif
+
+
+#ifdef MB_PORT_RTU_USING_DMA
+/**
+ * @brief  串口 DMA 发送完成回调（中断上下文）
+ *
+ * DE 为 MB_RTU_DE_TC 方式时在此释放 DE，总线切换时间与线程调度无关。
+ *
+ * @param[in] dev     串口设备
+ * @param[in] buffer  已发送完的缓冲区
+ *
+ * @return RT_EOK
+ */
+static rt_err_t modbus_port_rtu_tx_done(rt_device_t dev, void *buffer)
+{
+    mb_port_rtu_t *port = (mb_port_rtu_t *)dev->user_data;
+    if (port != NULL){
+        // HAL 在 UART TC 中断中回调, 最后一个停止位已发出, 立即释放总线
+        if ((port->de.mode == MB_RTU_DE_TC) && (port->de.pin >= 0)){
+            rt_pin_write(port->de.pin, ! port->de.lvl);
+        }
+        rt_event_send(&(port->evt), MB_PORT_EVT_TX);
+    }
+    return(RT_EOK);
+}
+#endif
+
+
+#ifdef MB_PORT_RTU_USING_HW_DE
+/**
+ * @brief  使能 USART 硬件 DE
+ *
+ * 置位 CR3.DEM，DE 极性由 CR3.DEP 选择，DEM 须在 UE=0 时修改。
+ * 引脚复用为 USARTx_DE 由板级初始化（CubeMX）完成。
+ *
+ * @return int  0-成功
+ */
+static int modbus_port_rtu_hw_de(mb_port_rtu_t *port)
+{
+    struct stm32_uart *uart = rt_container_of((struct rt_serial_device *)port->dev, struct stm32_uart, serial);
+    USART_TypeDef *regs = uart->handle.Instance;
+    rt_base_t level = rt_hw_interrupt_disable();
+    regs->CR1 &= ~USART_CR1_UE;
+    regs->CR3 |= USART_CR3_DEM;
+    if (port->de.lvl){
+        regs->CR3 &= ~USART_CR3_DEP;
+    }
+    else{
+        regs->CR3 |= USART_CR3_DEP;
+    }
+    regs->CR1 |= USART_CR1_UE;
+    rt_hw_interrupt_enable(level);
+    return(0);
+}
+#endif
+
+
+#ifdef MB_PORT_RTU_USING_TMR
+/**
+ * @brief  t3.5 硬件定时器超时回调（中断上下文）
+ *
+ * 最后一个字节后总线静默达到 t3.5，发送帧结束事件。
+ *
+ * @param[in] dev   定时器设备
+ * @param[in] size  未使用
+ *
+ * @return RT_EOK
+ */
+static rt_err_t modbus_port_rtu_tmr_ind(rt_device_t dev, rt_size_t size)
+{
+    mb_port_rtu_t *port = (mb_port_rtu_t *)dev->user_data;
+    if (port != NULL){
+        port->eof_seq = port->rx_seq;
+        rt_event_send(&(port->evt), MB_PORT_EVT_EOF);
+    }
+    return(RT_EOK);
+}
+
+
+/**
+ * @brief  打开 t3.5 硬件定时器
+ *
+ * @param[in,out] port  端口实例
+ * @param[in]     name  定时器设备名（如 "timer3"）
+ *
+ * @return int  0-成功, -1-失败（失败时回退到字节超时断帧）
+ */
+static int modbus_port_rtu_tmr_open(mb_port_rtu_t *port, const char *name)
+{
+    rt_device_t tmr = rt_device_find(name);
+    if (tmr == RT_NULL){
+        LOG_E("timer (%s) not found.", name);
+        return(-1);
+    }
+    if (rt_device_open(tmr, RT_DEVICE_OFLAG_RDWR) != RT_EOK){
+        LOG_E("timer (%s) open fail.", name);
+        return(-1);
+    }
+    rt_hwtimer_mode_t mode = HWTIMER_MODE_ONESHOT;
+    if (rt_device_control(tmr, HWTIMER_CTRL_MODE_SET, &mode) != RT_EOK){
+        LOG_E("timer (%s) mode set fail.", name);
+        rt_device_close(tmr);
+        return(-1);
+    }
+    tmr->user_data = (void *)port;
+    rt_device_set_rx_indicate(tmr, modbus_port_rtu_tmr_ind);
+    port->tmr = tmr;
+    return(0);
+}
+#endif
+
+
 /**
  * @brief  打开并初始化 RTU 串口设备（RS485/RS232）
  *
  * 支持波特率、奇偶校验、RS485 DE 引脚控制。
- * 返回 RT-Thread 设备句柄，供 read/write 使用。
+ * 返回 RTU 端口实例，供 read/write/wait 使用。
  *
  * @param[in] param  指向配置结构体的指针
  *   - dev:       串口设备名（如 "uart1"）
@@ -71,19 +368,28 @@ MB_WEAK void modbus_port_delay_ms(int tmo_ms)
  *   - parity:    奇偶校验（RT_SERIAL_PARITY_*）
  *   - pin:       RS485 DE 引脚，<0 表示无
  *   - lvl:       DE 高电平有效？1=高，0=低
+ *   - tmr:       t3.5 硬件定时器设备名，NULL 表示不使用
+ *   - dma:       1 使用 DMA 收发，0 中断收发
+ *   - de_mode:   DE 控制方式：软件、TC 中断释放或 USART 硬件 DE
  *
  * @return void*
- *   - 非 NULL : 设备句柄（rt_device_t）
+ *   - 非 NULL : 端口实例（mb_port_rtu_t*）
  *   - NULL    : 打开失败
  *
  * @note
- *   - 使用中断接收（RT_DEVICE_FLAG_INT_RX）
- *   - RS485 模式下，DE 引脚信息存入 dev->user_data
- *   - 编码格式：0xABCD0000 | (pin << 1) | lvl
+ *   - 缺省使用中断接收（RT_DEVICE_FLAG_INT_RX）
+ *   - dma=1 且串口驱动支持时使用 DMA 收发：接收由 DMA 半满/满和空闲中断
+ *     批量通知，一帧通常只产生一次中断；发送启动 DMA 后等待发送完成事件
+ *   - 接收 fifo 扩大到 MB_RTU_RX_BUFSZ，整帧到达前不会溢出
+ *   - 端口实例存入 dev->user_data，DE 配置保存在实例的 de 成员中
+ *   - MB_RTU_DE_TC 需要 DMA 发送，MB_RTU_DE_HW 需要 USART 支持 DEM，
+ *     条件不满足时回退到软件控制
+ *   - 启用 MB_USING_EVENT_RECV 时注册 rx_indicate 回调，接收由事件唤醒
+ *   - 启用 MB_USING_RTU_T35_FRAME 且配置了 tmr 时，每次接收重启单次定时器，
+ *     静默 t3.5 后发出帧结束事件，帧结束检测精度为微秒级
  *   - 可被用户重载（MB_WEAK）
  *
  * @warning
- *   - 必须在 mb_port_rtu_write() 中解析 user_data 切换 DE
  *   - 不要重复打开设备
  */
 MB_WEAK void * modbus_port_rtu_open(const mb_backend_param_t *param)
@@ -105,30 +411,105 @@ MB_WEAK void * modbus_port_rtu_open(const mb_backend_param_t *param)
     struct serial_configure cfg = RT_SERIAL_CONFIG_DEFAULT;
     cfg.baud_rate = param->rtu.baudrate;
     cfg.parity = param->rtu.parity;
+    if (cfg.bufsz < MB_RTU_RX_BUFSZ){
+        cfg.bufsz = MB_RTU_RX_BUFSZ;
+    }
     if (rt_device_control(dev, RT_DEVICE_CTRL_CONFIG, &cfg) < 0){
         LOG_E("device (%s) config fail.", name);
         return(NULL);
     }
-    // 6. 开启串口设备
-    if ( rt_device_open(dev, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_INT_RX) < 0){
+    // 6. 分配端口实例
+    mb_port_rtu_t *port = calloc(1, sizeof(mb_port_rtu_t));
+    if (port == NULL){
+        LOG_E("device (%s) port alloc fail.", name);
+        return(NULL);
+    }
+    port->dev = dev;
+    port->de.pin = param->rtu.pin;
+    port->de.lvl = param->rtu.lvl;
+    port->de.mode = param->rtu.de_mode;
+    #ifdef MB_USING_EVENT_RECV
+    rt_event_init(&(port->evt), "mb_rx", RT_IPC_FLAG_PRIO);
+    #endif
+    #ifdef MB_USING_RTU_T35_FRAME
+    port->t35_us = modbus_rtu_t35_us(param->rtu.baudrate);
+    #endif
+    #ifdef MB_PORT_RTU_USING_TMR
+    if (param->rtu.tmr != NULL){
+        modbus_port_rtu_tmr_open(port, param->rtu.tmr);
+    }
+    #endif
+    // 7. 选择收发方式, 驱动未配置对应 DMA 通道时回退到中断方式
+    rt_uint16_t oflag = RT_DEVICE_FLAG_INT_RX;
+    #ifdef MB_PORT_RTU_USING_DMA
+    if (param->rtu.dma){
+        if (dev->flag & RT_DEVICE_FLAG_DMA_RX){
+            oflag = RT_DEVICE_FLAG_DMA_RX;
+        }
+        if (dev->flag & RT_DEVICE_FLAG_DMA_TX){
+            oflag |= RT_DEVICE_FLAG_DMA_TX;
+            port->dma_tx = 1;
+        }
+        port->char_us = (MB_RTU_CHAR_BITS * 1000000 + param->rtu.baudrate - 1) / param->rtu.baudrate;
+    }
+    #else
+    if (param->rtu.dma){
+        LOG_W("device (%s) serial dma not enabled, use interrupt mode.", name);
+    }
+    #endif
+    // 8. 开启串口设备
+    if ( rt_device_open(dev, RT_DEVICE_OFLAG_RDWR | oflag) < 0){
         LOG_E("device (%s)  open fail.", name);
+        #ifdef MB_PORT_RTU_USING_TMR
+        if (port->tmr != NULL){
+            rt_device_close(port->tmr);
+        }
+        #endif
+        #ifdef MB_USING_EVENT_RECV
+        rt_event_detach(&(port->evt));
+        #endif
+        free(port);
         return(NULL);
     }
-    // 7. RS485 DE 引脚
-    int pin = param->rtu.pin;
-    // 8. 电平极性
-    int lvl = param->rtu.lvl;
+    dev->user_data = (void *)port;
+    #ifdef MB_USING_EVENT_RECV
+    rt_device_set_rx_indicate(dev, modbus_port_rtu_rx_ind);
+    #endif
+    #ifdef MB_PORT_RTU_USING_DMA
+    if (port->dma_tx){
+        rt_device_set_tx_complete(dev, modbus_port_rtu_tx_done);
+    }
+    #endif
+
+    // 9. RS485 DE 控制方式, 条件不满足时回退到软件控制
+    if (port->de.mode == MB_RTU_DE_HW){
+        #ifdef MB_PORT_RTU_USING_HW_DE
+        modbus_port_rtu_hw_de(port);
+        port->de.pin = -1;//引脚由 USART 控制
+        #else
+        LOG_W("device (%s) hardware DE not supported, use software DE.", name);
+        port->de.mode = MB_RTU_DE_SOFT;
+        #endif
+    }
+    if (port->de.mode == MB_RTU_DE_TC){
+        #ifdef MB_PORT_RTU_USING_DMA
+        if (! port->dma_tx)
+        #endif
+        {
+            LOG_W("device (%s) TC release of DE needs DMA TX, use software DE.", name);
+            port->de.mode = MB_RTU_DE_SOFT;
+        }
+    }
 
-    if (pin >= 0){
-        uint32_t ud = 0xABCD0000 + ((pin << 1) & 0xFFFF)  + (lvl ? 1 : 0);
-        dev->user_data = (void *)ud;
-        rt_pin_mode(pin, PIN_MODE_OUTPUT);
-        rt_pin_write(pin, ! lvl);
+    // 10. RS485 DE 引脚, 默认接收状态
+    if (port->de.pin >= 0){
+        rt_pin_mode(port->de.pin, PIN_MODE_OUTPUT);
+        rt_pin_write(port->de.pin, ! port->de.lvl);
     }
 
     LOG_D("device (%s) open suceess.", name);
 
-    return((void *)dev);
+    return((void *)port);
 }
 
 
@@ -138,7 +519,7 @@ MB_WEAK void * modbus_port_rtu_open(const mb_backend_param_t *param)
  * 释放 modbus_port_rtu_open() 打开的设备资源。
  * 关闭后，hinst 失效，不可再用于 read/write。
  *
- * @param[in] hinst  设备句柄（由 modbus_port_rtu_open() 返回）
+ * @param[in] hinst  端口实例（由 modbus_port_rtu_open() 返回）
  *
  * @return int
  *   - 0  : 关闭成功
@@ -148,8 +529,30 @@ MB_WEAK int modbus_port_rtu_close(void *hinst)
 {
     MB_ASSERT(hinst != NULL);
 
-    rt_device_t dev = (rt_device_t)hinst;
-    return(rt_device_close(dev));
+    mb_port_rtu_t *port = (mb_port_rtu_t *)hinst;
+    rt_device_t dev = port->dev;
+    #ifdef MB_USING_EVENT_RECV
+    rt_device_set_rx_indicate(dev, RT_NULL);
+    #endif
+    #ifdef MB_PORT_RTU_USING_DMA
+    if (port->dma_tx){
+        rt_device_set_tx_complete(dev, RT_NULL);
+    }
+    #endif
+    int rst = rt_device_close(dev);
+    dev->user_data = NULL;
+    #ifdef MB_PORT_RTU_USING_TMR
+    if (port->tmr != NULL){
+        rt_device_set_rx_indicate(port->tmr, RT_NULL);
+        rt_device_close(port->tmr);
+        port->tmr->user_data = NULL;
+    }
+    #endif
+    #ifdef MB_USING_EVENT_RECV
+    rt_event_detach(&(port->evt));
+    #endif
+    free(port);
+    return(rst);
 }
 
 
@@ -159,7 +562,7 @@ MB_WEAK int modbus_port_rtu_close(void *hinst)
  * 使用 RT-Thread 设备框架读取串口数据。
  * 配合 RT_DEVICE_FLAG_INT_RX 实现中断驱动接收。
  *
- * @param[in]  hinst    设备句柄（由 modbus_port_rtu_open() 返回）
+ * @param[in]  hinst    端口实例（由 modbus_port_rtu_open() 返回）
  * @param[out] buf      接收缓冲区
  * @param[in]  bufsize  缓冲区大小（>0）
  *
@@ -179,7 +582,7 @@ MB_WEAK int modbus_port_rtu_read(void *hinst, uint8_t *buf, int bufsize)
     MB_ASSERT(hinst != NULL);
     MB_ASSERT(buf != NULL);
 
-    rt_device_t dev = (rt_device_t)hinst;
+    rt_device_t dev = ((mb_port_rtu_t *)hinst)->dev;
     int len = rt_device_read(dev, -1, buf, bufsize);
     if (len < 0)
     {
@@ -194,10 +597,9 @@ MB_WEAK int modbus_port_rtu_read(void *hinst, uint8_t *buf, int bufsize)
 /**
  * @brief  向 RTU 串口发送数据（支持 RS485 半双工）
  *
- * 自动控制 DE 引脚切换发送/接收模式。
- * 发送完成后立即恢复接收状态。
+ * 按端口的 DE 控制方式切换发送/接收模式，发送完成后恢复接收状态。
  *
- * @param[in] hinst  设备句柄
+ * @param[in] hinst  端口实例
  * @param[in] buf    发送缓冲区
  * @param[in] size   发送字节数（1~256）
  *
@@ -206,33 +608,49 @@ MB_WEAK int modbus_port_rtu_read(void *hinst, uint8_t *buf, int bufsize)
  *   - -1 : 发送失败
  *
  * @note
- *   - DE 引脚信息来自 modbus_port_rtu_open() 的 user_data
- *   - 魔数 0xABCD0000 标识有效配置
- *   - 非阻塞写入（offset = -1）
- *   - 发送后立即切回接收，防止总线冲突
+ *   - DE 配置来自端口实例（modbus_port_rtu_open() 中保存）
+ *   - MB_RTU_DE_SOFT：中断发送时驱动逐字节等待 TC，返回即最后一个停止位已发出，
+ *     但释放时刻受线程调度影响
+ *   - MB_RTU_DE_TC：在发送完成中断中释放 DE，切换时间确定且最短
+ *   - MB_RTU_DE_HW：由 USART 硬件在停止位结束后释放，软件不操作引脚
+ *   - DMA 发送直接使用 buf，等待发送完成事件后才返回；
+ *     超时未完成时释放 DE 并返回 -1，由实例关闭后端（停止 DMA），重新连接后恢复
  */
 MB_WEAK int modbus_port_rtu_write(void *hinst, uint8_t *buf, int size)
 {
     MB_ASSERT(hinst != NULL);
     MB_ASSERT(buf != NULL);
 
-    // 1. 类型转换
-    rt_device_t dev = (rt_device_t)hinst;
-    // 2. 读取 user_data
-    uint32_t ud = (uint32_t)(dev->user_data);
-    // 3. 魔术字段匹配 -> 是 -> 提取pin
-    int pin = ((ud & 0xFFFF0000) == 0xABCD0000) ? ((ud & 0xFFFF) >> 1) : -1;
-    // 4. 提取电平极性
-    int lvl = (ud & 0x01);
-    // 5. 发送模式（DE 高）
-    if (pin >= 0) rt_pin_write(pin, lvl);
-    // 6. 非阻塞发送
-    int len = rt_device_write(dev, -1, buf, size);
-    // 7. 接收模式（DE 低）
-    if (pin >= 0) rt_pin_write(pin, ! lvl);
+    mb_port_rtu_t *port = (mb_port_rtu_t *)hinst;
+    mb_port_rtu_de_t *de = &(port->de);
+    int len;
+    // 1. 发送模式（DE 有效）
+    if (de->pin >= 0) rt_pin_write(de->pin, de->lvl);
+    // 2. 发送
+    #ifdef MB_PORT_RTU_USING_DMA
+    if (port->dma_tx){
+        rt_event_recv(&(port->evt), MB_PORT_EVT_TX, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, 0, RT_NULL);
+        len = rt_device_write(port->dev, -1, buf, size);
+        if (len > 0){
+            int tmo_ms = (size * port->char_us) / 1000 + 10;
+            if (rt_event_recv(&(port->evt), MB_PORT_EVT_TX, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
+                              rt_tick_from_millisecond(tmo_ms), RT_NULL) != RT_EOK){
+                // 发送未完成, 返回错误由实例关闭后端(关闭串口时停止 DMA 并丢弃发送队列), 下次 modbus_connect() 重新打开
+                LOG_E("device dma write timeout.");
+                len = -1;
+            }
+        }
+    }
+    else
+    #endif
+    {
+        len = rt_device_write(port->dev, -1, buf, size);
+    }
+    // 3. 接收模式（DE 无效）, TC 方式已在中断中释放(超时未完成时在此兜底)
+    if (de->pin >= 0) rt_pin_write(de->pin, ! de->lvl);
 
     if (len < 0){
-        LOG_E("device read error.");
+        LOG_E("device write error.");
         return(-1);
     }
 
@@ -246,45 +664,116 @@ MB_WEAK int modbus_port_rtu_write(void *hinst, uint8_t *buf, int size)
  * 丢弃所有残留数据，确保下次接收从干净状态开始。
  * 常用于初始化、错误恢复、帧同步。
  *
- * @param[in] hinst  设备句柄（由 modbus_port_rtu_open() 返回）
+ * @param[in] hinst  端口实例（由 modbus_port_rtu_open() 返回）
  *
  * @return int
  *   -  0 : 清空成功
  *   - -1 : 设备错误（读取失败）
  *
  * @note
- *   - 使用非阻塞读取（offset = -1）
- *   - 循环直到缓冲区为空（len == 0）
+ *   - 串口 V1 中断/DMA 接收时在关中断下直接复位接收 fifo 读位置，
+ *     无论残留多少数据都是 O(1)
+ *   - 其他串口框架或无接收 fifo 时（轮询模式）循环非阻塞读取直到无数据
+ *   - 同时清除未处理的接收事件
  *   - 不影响发送缓冲区
  *   - 可被用户重载（MB_WEAK）
  *
  * @warning
  *   - 必须在接收状态（DE=低）下调用
- *   - 避免在高频任务中调用（可能影响实时性）
  */
 MB_WEAK int modbus_port_rtu_flush(void *hinst)
 {
     MB_ASSERT(hinst != NULL);
 
-    uint8_t c;
-    rt_device_t dev = (rt_device_t)hinst;
-    while(1)
+    mb_port_rtu_t *port = (mb_port_rtu_t *)hinst;
+    rt_device_t dev = port->dev;
+    #ifdef RT_USING_SERIAL_V1
+    struct rt_serial_rx_fifo *fifo = (struct rt_serial_rx_fifo *)((struct rt_serial_device *)dev)->serial_rx;
+    if (fifo != RT_NULL)
     {
-        int len = rt_device_read(dev, -1, &c, 1);
-        if (len < 0){
-            return(-1);
-        }
-        if (len == 0){
-            break;
+        rt_base_t level = rt_hw_interrupt_disable();
+        fifo->get_index = fifo->put_index;
+        fifo->is_full = RT_FALSE;
+        #ifdef MB_PORT_RTU_USING_ISR_CRC
+        port->crc_idx = fifo->put_index;
+        #endif
+        rt_hw_interrupt_enable(level);
+    }
+    else
+    #endif
+    {
+        uint8_t tmp[32];
+        while(1)
+        {
+            int len = rt_device_read(dev, -1, tmp, sizeof(tmp));
+            if (len < 0){
+                return(-1);
+            }
+            if (len < (int)sizeof(tmp)){
+                break;
+            }
         }
     }
 
+    #ifdef MB_USING_EVENT_RECV
+    // 清除未处理的接收事件, 不等待
+    rt_event_recv(&(port->evt), MB_PORT_EVT_RX | MB_PORT_EVT_EOF, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, 0, RT_NULL);
+    #endif
+
     return(0);
 }
 
 
 
 
+#ifdef MB_USING_EVENT_RECV
+/**
+ * @brief  阻塞等待 RTU 串口接收数据
+ *
+ * 在接收事件上挂起当前线程，直到串口接收回调发出事件或超时。
+ * 取代轮询读 + 2ms 延时，空闲时不占用 CPU，唤醒精度为系统 tick。
+ *
+ * @param[in] hinst   端口实例（由 modbus_port_rtu_open() 返回）
+ * @param[in] tmo_ms  最长等待时间（毫秒），<=0 时立即返回
+ *
+ * @return int
+ *   -  2 : 帧结束（t3.5 静默，仅使用硬件定时器时）
+ *   -  1 : 有新数据到达
+ *   -  0 : 等待超时
+ *
+ * @note
+ *   - 事件标志带自动清除，回调多次触发只唤醒一次，不会累积
+ *   - 读空后再等待，若期间已有数据到达，事件已置位会立即返回
+ *   - 帧结束事件之后又收到数据时该事件已过期，按收到数据返回
+ *   - 可被用户重载（MB_WEAK）
+ */
+MB_WEAK int modbus_port_rtu_wait(void *hinst, int tmo_ms)
+{
+    MB_ASSERT(hinst != NULL);
+
+    mb_port_rtu_t *port = (mb_port_rtu_t *)hinst;
+    rt_uint32_t recved = 0;
+    rt_int32_t tick = (tmo_ms > 0) ? rt_tick_from_millisecond(tmo_ms) : 0;
+    rt_err_t rst = rt_event_recv(&(port->evt), MB_PORT_EVT_RX | MB_PORT_EVT_EOF,
+                                 RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
+                                 tick, &recved);
+    if (rst != RT_EOK){
+        return(0);
+    }
+
+    #ifdef MB_PORT_RTU_USING_TMR
+    // 帧结束事件发出后又有新数据到达, 该事件已过期, 按收到数据处理
+    if ((recved & MB_PORT_EVT_EOF) && (port->eof_seq != port->rx_seq)){
+        return(MB_BKD_WAIT_RX);
+    }
+    #endif
+
+    return((recved & MB_PORT_EVT_EOF) ? MB_BKD_WAIT_EOF : MB_BKD_WAIT_RX);
+}
+#endif
+
+
+
 /**
  * @brief  RTU 后端操作函数表（虚函数表）
  *
@@ -292,6 +781,7 @@ MB_WEAK int modbus_port_rtu_flush(void *hinst)
  * - 打开/关闭串口
  * - 读写数据（含 RS485 方向控制）
  * - 清空缓存
+ * - 阻塞等待接收（启用 MB_USING_EVENT_RECV 时）
  *
  * @note 使用静态常量，避免重复初始化
  */
@@ -301,7 +791,13 @@ static const mb_backend_ops_t mb_port_rtu_ops =
     .close = modbus_port_rtu_close,
     .read  = modbus_port_rtu_read,
     .write = modbus_port_rtu_write,
-    .flush = modbus_port_rtu_flush
+    .flush = modbus_port_rtu_flush,
+    #ifdef MB_USING_EVENT_RECV
+    .wait  = modbus_port_rtu_wait,
+    #endif
+    #ifdef MB_PORT_RTU_USING_ISR_CRC
+    .rx_crc = modbus_port_rtu_rx_crc,
+    #endif
 };
 
 
@@ -318,6 +814,7 @@ static const mb_backend_ops_t mb_port_rtu_ops =
  *                 - parity: 校验位
  *                 - pin: RS485 DE 引脚（-1 表示不使用）
  *                 - lvl: DE 电平逻辑
+ *                 - tmr: t3.5 硬件定时器设备名（NULL 表示不使用）
  *
  * @return mb_backend_t*  成功：RTU 后端指针
  * @return NULL           失败：内存不足、strdup 失败
@@ -325,6 +822,7 @@ static const mb_backend_ops_t mb_port_rtu_ops =
  * @note
  *   - 使用 strdup 深拷贝设备名，确保后端生命周期独立
  *   - 默认超时：ack=300ms, byte=32ms
+ *   - 启用 MB_USING_RTU_T35_FRAME 时字节超时按波特率取 t3.5（向上取整到毫秒）
  *   - 底层句柄 hinst 初始为 NULL，需调用 mb_backend_open() 打开
  *
  * @warning
@@ -340,9 +838,15 @@ static mb_backend_t * modbus_backend_create_rtu(const mb_backend_param_rtu_t *rt
         backend->type = MB_BACKEND_TYPE_RTU;
         backend->param.rtu = *rtu;
         backend->param.rtu.dev = strdup(rtu->dev);
+        backend->param.rtu.tmr = (rtu->tmr != NULL) ? strdup(rtu->tmr) : NULL;
         backend->ops = &mb_port_rtu_ops;
         backend->ack_tmo_ms = MB_BKD_ACK_TMO_MS_DEF;
+        #ifdef MB_USING_RTU_T35_FRAME
+        // t3.5 向上取整到毫秒, 至少 1ms
+        backend->byte_tmo_ms = (modbus_rtu_t35_us(rtu->baudrate) + 999) / 1000;
+        #else
         backend->byte_tmo_ms = MB_BKD_BYTE_TMO_MS_DEF;
+        #endif
         backend->hinst = NULL;
     }
 
@@ -367,6 +871,12 @@ static mb_backend_t * modbus_backend_create_rtu(const mb_backend_param_rtu_t *rt
 #include <netdb.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#if (defined(MB_USING_EVENT_RECV) && defined(RT_USING_POSIX_POLL))
+#include <poll.h>
+#elif defined(MB_USING_EVENT_RECV)
+#include <sys/time.h>
+#endif
 
 
 /**
@@ -521,8 +1031,7 @@ MB_WEAK int modbus_port_tcp_read(void *hinst, uint8_t *buf, int bufsize)
  *
  * @note
  *   - 阻塞模式下，send() 会自动重试直到全部发送
- *   - 若返回 len < size，应循环发送剩余部分
- *   - 上层应检查返回值是否等于 size
+ *   - 设置了 SO_SNDTIMEO 时超时或只发出部分数据均返回 -1（帧不完整，连接应断开）
  *   - 可被用户重载（MB_WEAK）
  */
 MB_WEAK int modbus_port_tcp_write(void *hinst, uint8_t *buf, size_t size)
@@ -532,11 +1041,16 @@ MB_WEAK int modbus_port_tcp_write(void *hinst, uint8_t *buf, size_t size)
 
     int sock = (int)hinst;
     int len = send(sock, buf, size, 0);
-    if (len <= 0)//socket已关闭
+    if (len <= 0)//socket已关闭或发送超时
     {
         LOG_E("TCP write error.");
         return(-1);
     }
+    if (len < (int)size)//设置了发送超时时可能只发出部分, 帧已不完整
+    {
+        LOG_E("TCP write incomplete (%d/%d).", len, (int)size);
+        return(-1);
+    }
 
     return(len);
 }
@@ -555,8 +1069,9 @@ MB_WEAK int modbus_port_tcp_write(void *hinst, uint8_t *buf, size_t size)
  *   - -1 : 连接已关闭（对端发送 FIN）
  *
  * @note
- *   - 使用非阻塞读取（MSG_DONTWAIT）
- *   - 循环直到缓冲区为空（len < 0 且 errno == EAGAIN）
+ *   - 使用非阻塞读取（MSG_DONTWAIT），每次读入整块临时缓冲区，
+ *     通常一次调用即可清空
+ *   - 循环直到读出不足一块或无数据（len < 0 且 errno == EAGAIN）
  *   - 不影响发送缓冲区
  *   - 可被用户重载（MB_WEAK）
  */
@@ -564,16 +1079,16 @@ MB_WEAK int modbus_port_tcp_flush(void *hinst)
 {
     MB_ASSERT(hinst != NULL);
 
-    uint8_t c;
+    uint8_t tmp[MB_BKD_RSV_SIZE];
     int sock = (int)hinst;
     while(1)
     {
-        int len = recv(sock, &c, 1, MSG_DONTWAIT);
+        int len = recv(sock, tmp, sizeof(tmp), MSG_DONTWAIT);
         if (len == 0)//socket已关闭
         {
             return(-1);
         }
-        if (len < 0)//超时或其它错误
+        if ((len < 0) || (len < (int)sizeof(tmp)))//已清空或其它错误
         {
             break;
         }
@@ -581,6 +1096,76 @@ MB_WEAK int modbus_port_tcp_flush(void *hinst)
     return(0);
 }
 
+#ifdef MB_USING_EVENT_RECV
+/**
+ * @brief  阻塞等待 TCP socket 接收数据
+ *
+ * 挂起当前线程直到 socket 可读、连接关闭或超时。
+ *
+ * @param[in] hinst   socket 句柄（由 modbus_port_tcp_open() 返回）
+ * @param[in] tmo_ms  最长等待时间（毫秒），<=0 时立即返回
+ *
+ * @return int
+ *   -  1 : socket 可读（有数据或对端已关闭，由 read 进一步判断）
+ *   -  0 : 等待超时
+ *   - -1 : socket 错误
+ *
+ * @note
+ *   - 启用 RT_USING_POSIX_POLL 时使用 SAL poll()
+ *   - 否则设置 SO_RCVTIMEO 后以 MSG_PEEK 阻塞接收 1 字节，不消耗数据，返回前恢复 SO_RCVTIMEO；
+ *     连接复位等错误返回 -1，不按超时处理
+ *   - 可被用户重载（MB_WEAK）
+ */
+MB_WEAK int modbus_port_tcp_wait(void *hinst, int tmo_ms)
+{
+    MB_ASSERT(hinst != NULL);
+
+    int sock = (int)hinst;
+    if (tmo_ms < 0){
+        tmo_ms = 0;
+    }
+
+    #ifdef RT_USING_POSIX_POLL
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int rst = poll(&pfd, 1, tmo_ms);
+    if (rst < 0){
+        LOG_E("TCP poll error.");
+        return(-1);
+    }
+    return((rst > 0) ? 1 : 0);
+    #else
+    struct timeval tv;
+    tv.tv_sec = tmo_ms / 1000;
+    tv.tv_usec = (tmo_ms % 1000) * 1000;
+    if ((tv.tv_sec == 0) && (tv.tv_usec == 0)){
+        tv.tv_usec = 1000;//0 表示永久阻塞, 至少等待 1ms
+    }
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0){
+        LOG_E("TCP set recv timeout error.");
+        return(-1);
+    }
+    uint8_t c;
+    int len = recv(sock, &c, 1, MSG_PEEK);
+    int err = errno;
+    // 恢复为永久阻塞, 接收超时只作用于本次等待
+    tv.tv_sec = 0;
+    tv.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (len >= 0){
+        return(1);//len == 0 为对端关闭, 交由 read 报告错误
+    }
+    if ((err == EAGAIN) || (err == EWOULDBLOCK) || (err == EINTR)){
+        return(0);
+    }
+    LOG_E("TCP wait error (%d).", err);
+    return(-1);
+    #endif
+}
+#endif
+
 #endif
 
 
@@ -599,11 +1184,14 @@ MB_WEAK int modbus_port_tcp_flush(void *hinst)
  */
 static const mb_backend_ops_t mb_port_tcp_ops =
 {
-    modbus_port_tcp_open,
-    modbus_port_tcp_close,
-    modbus_port_tcp_read,
-    modbus_port_tcp_write,
-    modbus_port_tcp_flush
+    .open  = modbus_port_tcp_open,
+    .close = modbus_port_tcp_close,
+    .read  = modbus_port_tcp_read,
+    .write = modbus_port_tcp_write,
+    .flush = modbus_port_tcp_flush,
+    #ifdef MB_USING_EVENT_RECV
+    .wait  = modbus_port_tcp_wait,
+    #endif
 };
 
 
@@ -666,11 +1254,14 @@ static mb_backend_t *modbus_backend_create_tcp(const mb_backend_param_tcp_t *tcp
  */
 static const mb_backend_ops_t mb_port_sock_ops =
 {
-    NULL,
-    modbus_port_tcp_close,
-    modbus_port_tcp_read,
-    modbus_port_tcp_write,
-    modbus_port_tcp_flush
+    .open  = NULL,
+    .close = modbus_port_tcp_close,
+    .read  = modbus_port_tcp_read,
+    .write = modbus_port_tcp_write,
+    .flush = modbus_port_tcp_flush,
+    #ifdef MB_USING_EVENT_RECV
+    .wait  = modbus_port_tcp_wait,
+    #endif
 };
 
 
@@ -822,6 +1413,11 @@ void modbus_backend_destory(mb_backend_t *backend)
             free(backend->param.rtu.dev);
             backend->param.rtu.dev = NULL;
         }
+        if (backend->param.rtu.tmr)
+        {
+            free(backend->param.rtu.tmr);
+            backend->param.rtu.tmr = NULL;
+        }
         break;
     #endif
 
@@ -882,6 +1478,7 @@ int modbus_backend_open(mb_backend_t *backend)//打开后端, 成功返回0, 错
     if (backend->hinst == NULL){
         return(-1);
     }
+    backend->rsv_len = 0;
     return(0);
 }
 
@@ -926,6 +1523,7 @@ int modbus_backend_close(mb_backend_t *backend)
         return(-1);
     }
     backend->hinst = NULL;
+    backend->rsv_len = 0;
     return(0);
 }
 
@@ -966,15 +1564,19 @@ int modbus_backend_timeout_config(mb_backend_t *backend, int ack_tmo_ms, int byt
 
 
 /**
- * @brief  从后端读取数据（支持应答超时 + 字节间超时）
+ * @brief  从后端读取一帧数据（支持应答超时 + 字节间超时 + 帧长度预测）
  *
  * 实现 Modbus 协议帧同步的核心逻辑：
  *   - 第一次字节：使用应答超时（ack_tmo_ms）
  *   - 后续字节：使用字节间超时（byte_tmo_ms）
+ *   - 提供帧长度预测函数时，收满预测长度立即返回，不再等待字节超时
  *
  * @param[in,out] backend  后端实例指针
  * @param[out]    buf      接收缓冲区
  * @param[in]     bufsize  缓冲区大小（>0）
+ * @param[in]     frm_len  帧长度预测函数，NULL 表示仅依靠超时断帧
+ * @param[in]     type     传给 frm_len 的帧类型（mb_pdu_type_t）
+ * @param[in]     ack_tmo_ms  本次应答超时（毫秒），modbus_backend_read_frame() 使用配置的 backend->ack_tmo_ms
  *
  * @retval >0  成功接收的字节数（可能是一完整帧）
  * @retval  0  超时（应答超时或字节间超时）
@@ -982,14 +1584,23 @@ int modbus_backend_timeout_config(mb_backend_t *backend, int ack_tmo_ms, int byt
  *
  * @note
  *   - 每次收到字节会重置计时器
- *   - 每轮循环延时 2ms，避免 CPU 100%
+ *   - 后端提供 wait() 时（MB_USING_EVENT_RECV），在剩余超时内阻塞等待数据事件，
+ *     空闲不占 CPU，响应检测精度为系统 tick
+ *   - wait() 报告帧结束（RTU t3.5 硬件定时）时立即返回，不再等待字节超时
+ *   - 否则每轮循环延时 2ms 轮询，避免 CPU 100%
  *   - 底层 read() 应为非阻塞模式
+ *   - frm_len 返回 0 或 -1（功能码未知）时继续按超时断帧
+ *   - 流式后端（TCP/SOCK）提供 frm_len 时按长度精确切帧：超出本帧的数据存入
+ *     残留缓冲区供下次读取，粘包/半包均可正确处理；帧内不使用字节间超时，
+ *     整帧等待上限为应答超时；超时时未收完的半帧同样保留，本次返回 0；
+ *     保留的数据供流水线和服务器继续拼接，同步主站每次请求前经 modbus_flush() 清空
+ *     帧长度无法判断时视为流已失步，直接返回
  *
  * @warning
  *   - 必须先调用 mb_backend_open()
  *   - 超时值由 modbus_backend_timeout_config() 设置
  */
-int modbus_backend_read(mb_backend_t *backend, uint8_t *buf, int bufsize)
+int modbus_backend_read_frame_tmo(mb_backend_t *backend, uint8_t *buf, int bufsize, modbus_bkd_frm_len_t frm_len, int type, int ack_tmo_ms)
 {
     if ((backend == NULL) || (buf == NULL) || (bufsize <= 0))
     {
@@ -1003,11 +1614,50 @@ int modbus_backend_read(mb_backend_t *backend, uint8_t *buf, int bufsize)
     {
         return(-1);
     }
+    int stream = (backend->type != MB_BACKEND_TYPE_RTU) && (frm_len != NULL);//流式按长度切帧
     int pos = 0;
+    if (stream && (backend->rsv_len > 0))//先取用上次残留的数据
+    {
+        pos = (backend->rsv_len < bufsize) ? backend->rsv_len : bufsize;
+        memcpy(buf, backend->rsv, pos);
+        backend->rsv_len -= pos;
+        memmove(backend->rsv, backend->rsv + pos, backend->rsv_len);
+    }
+    if ((pos == 0) && (backend->ops->rx_crc != NULL))//新帧开始, 接收中断重新累计CRC
+    {
+        backend->ops->rx_crc(backend->hinst, 0);
+    }
     long long told_ms = modbus_port_get_ms();
     while(pos < bufsize)
     {
-        int len = backend->ops->read(backend->hinst, buf + pos, bufsize - pos);
+        if (frm_len != NULL)//已收满预测的帧长度, 立即返回
+        {
+            int need = frm_len(buf, pos, type);
+            if ((need > 0) && (pos >= need))
+            {
+                if (stream && (pos > need))//超出本帧的部分留给下一帧
+                {
+                    memcpy(backend->rsv, buf + need, pos - need);
+                    backend->rsv_len = pos - need;
+                    pos = need;
+                }
+                break;
+            }
+            if (stream && (need < 0))//帧头非法, 流已失步
+            {
+                break;
+            }
+        }
+        if (stream && (backend->rsv_len > 0))//残留数据未取完(接收缓冲区已满)
+        {
+            break;
+        }
+        int size = bufsize - pos;
+        if (stream && (size > MB_BKD_RSV_SIZE))//保证超出部分能全部存入残留缓冲区
+        {
+            size = MB_BKD_RSV_SIZE;
+        }
+        int len = backend->ops->read(backend->hinst, buf + pos, size);
         if (len < 0)//发生错误
         {
             return(-1);
@@ -1019,26 +1669,85 @@ int modbus_backend_read(mb_backend_t *backend, uint8_t *buf, int bufsize)
             continue;
         }
         int tmo_ms = modbus_port_get_ms() - told_ms;
-        if (pos)//已有数据接收到, 则检查字节超时
+        int limit_ms = (pos && !stream) ? backend->byte_tmo_ms : ack_tmo_ms;//已有数据则检查字节超时, 否则检查应答超时
+        if ((tmo_ms > limit_ms) || (limit_ms <= 0))//超时了, 超时为0时不等待(非阻塞接收)
         {
-            if (tmo_ms > backend->byte_tmo_ms)//字节超时了
-            {
-                break;
-            }
+            break;
+        }
+        if (backend->ops->wait == NULL)//不支持阻塞等待, 轮询
+        {
+            modbus_port_delay_ms(2);
+            continue;
+        }
+        int rst = backend->ops->wait(backend->hinst, limit_ms - tmo_ms + 1);
+        if (rst < 0)//发生错误
+        {
+            return(-1);
+        }
+        if (rst == 0)//剩余时间内无数据, 超时
+        {
+            break;
         }
-        else//未收到过数据, 则检查应答超时
+        if ((rst == MB_BKD_WAIT_EOF) && pos)//检测到 t3.5 帧结束, 取走剩余数据后返回
         {
-            if (tmo_ms > backend->ack_tmo_ms)//应答超时了
+            len = backend->ops->read(backend->hinst, buf + pos, bufsize - pos);
+            if (len < 0)
             {
-                break;
+                return(-1);
             }
+            pos += len;
+            break;
+        }
+    }
+    if (stream && (pos > 0) && (pos <= MB_BKD_RSV_SIZE) && (backend->rsv_len == 0))//超时仍为半帧, 保留到下次接收继续拼接, 避免流失步
+    {
+        int need = frm_len(buf, pos, type);
+        if ((need == 0) || (need > pos))
+        {
+            memcpy(backend->rsv, buf, pos);
+            backend->rsv_len = pos;
+            pos = 0;
         }
-        modbus_port_delay_ms(2);
     }
     return(pos);
 }
 
 
+/**
+ * @brief  从后端读取一帧数据，应答超时使用配置值
+ *
+ * 见 modbus_backend_read_frame_tmo()。
+ */
+int modbus_backend_read_frame(mb_backend_t *backend, uint8_t *buf, int bufsize, modbus_bkd_frm_len_t frm_len, int type)
+{
+    if (backend == NULL)
+    {
+        return(-1);
+    }
+    return(modbus_backend_read_frame_tmo(backend, buf, bufsize, frm_len, type, backend->ack_tmo_ms));
+}
+
+
+
+/**
+ * @brief  从后端读取数据（支持应答超时 + 字节间超时）
+ *
+ * 不做帧长度预测的 modbus_backend_read_frame()，仅依靠超时断帧。
+ *
+ * @param[in,out] backend  后端实例指针
+ * @param[out]    buf      接收缓冲区
+ * @param[in]     bufsize  缓冲区大小（>0）
+ *
+ * @retval >0  成功接收的字节数
+ * @retval  0  超时（应答超时或字节间超时）
+ * @retval -1  错误（参数错误、未打开、ops 错误、底层 read 失败）
+ */
+int modbus_backend_read(mb_backend_t *backend, uint8_t *buf, int bufsize)
+{
+    return(modbus_backend_read_frame(backend, buf, bufsize, NULL, 0));
+}
+
+
 /**
  * @brief  向后端写入数据
  *
@@ -1091,7 +1800,9 @@ int modbus_backend_write(mb_backend_t *backend, uint8_t *buf, int size)
  * @retval -1  错误（参数错误、未打开、ops 错误）
  *
  * @note
- *   - 串口/TCP：循环非阻塞 read 直到无数据
+ *   - 串口：直接复位接收 fifo；TCP：整块非阻塞 recv 直到无数据
+ *   - 只丢弃已到达的数据，正在传输的帧后半部分仍会到达，
+ *     需要按总线静默重新同步时使用 modbus_backend_discard()
  *
  * @warning
  *   - 必须先调用 mb_backend_open()
@@ -1110,10 +1821,104 @@ int modbus_backend_flush(mb_backend_t *backend)
     {
         return(-1);
     }
+    backend->rsv_len = 0;
     return(backend->ops->flush(backend->hinst));
 }
 
 
+/**
+ * @brief  丢弃数据直到总线静默
+ *
+ * 先清空接收缓冲区，再持续读取丢弃，直到连续 silence_ms 内没有新数据，
+ * 用于 RTU 冲突或噪声后重新对齐帧边界（下一字节必为新帧的首字节）。
+ *
+ * @param[in,out] backend     后端实例指针
+ * @param[in]     silence_ms  静默时间（毫秒），<=0 时使用字节超时
+ * @param[in]     max_ms      最长丢弃时间（毫秒），总线一直繁忙时到时返回
+ *
+ * @retval >=0  丢弃的字节数（不含清空缓冲区时丢弃的数据）
+ * @retval  -1  错误（参数错误、未打开、ops 错误、底层 read 失败）
+ */
+int modbus_backend_discard(mb_backend_t *backend, int silence_ms, int max_ms)
+{
+    if (modbus_backend_flush(backend) < 0)
+    {
+        return(-1);
+    }
+    if (backend->ops->read == NULL)
+    {
+        return(-1);
+    }
+    if (silence_ms <= 0)
+    {
+        silence_ms = backend->byte_tmo_ms;
+    }
+
+    uint8_t tmp[32];
+    int cnt = 0;
+    long long tstart_ms = modbus_port_get_ms();
+    long long told_ms = tstart_ms;
+    while(1)
+    {
+        int len = backend->ops->read(backend->hinst, tmp, sizeof(tmp));
+        if (len < 0)
+        {
+            return(-1);
+        }
+        long long tnow_ms = modbus_port_get_ms();
+        if (len > 0)
+        {
+            cnt += len;
+            told_ms = tnow_ms;
+            continue;
+        }
+        if (((tnow_ms - told_ms) >= silence_ms) || ((tnow_ms - tstart_ms) >= max_ms))
+        {
+            break;
+        }
+        if (backend->ops->wait != NULL)
+        {
+            int wait_ms = silence_ms - (int)(tnow_ms - told_ms);
+            if (backend->ops->wait(backend->hinst, (wait_ms > 0) ? wait_ms : 1) < 0)
+            {
+                return(-1);
+            }
+        }
+        else
+        {
+            modbus_port_delay_ms(1);
+        }
+    }
+
+    return(cnt);
+}
+
+
+/**
+ * @brief  取最近一帧在接收中断中累计的 CRC 校验结果
+ *
+ * 在 modbus_backend_read_frame() 返回后调用，len 为其返回值。
+ *
+ * @param[in] backend  后端实例指针
+ * @param[in] len      刚读出的帧长度
+ *
+ * @return int  1-校验正确, 0-校验错误, -1-未知（后端不支持或无法判断，需自行计算）
+ */
+int modbus_backend_rx_crc(mb_backend_t *backend, int len)
+{
+    if ((backend == NULL) || (backend->hinst == NULL) || (len <= 0))
+    {
+        return(-1);
+    }
+    if ((backend->ops == NULL) || (backend->ops->rx_crc == NULL))
+    {
+        return(-1);
+    }
+
+    return(backend->ops->rx_crc(backend->hinst, len));
+}
+
+
 
 
 
@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+
+#include "bsp_sys.h"
+
+#if (defined(MB_USING_BUS) && defined(MB_USING_MASTER))
+
+#define DBG_TAG "mb.bus"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+
+/**
+ * @brief  初始化从机上下文
+ *
+ * 使用总线默认超时、ABCD 字序，无轮询点，状态为在线。
+ *
+ * @param[out] ctx    从机上下文
+ * @param[in]  saddr  从机地址
+ */
+void modbus_slave_ctx_init(mb_slave_ctx_t *ctx, uint8_t saddr)
+{
+    MB_ASSERT(ctx != NULL);
+
+    memset(ctx, 0, sizeof(mb_slave_ctx_t));
+    ctx->saddr = saddr;
+    ctx->order = MB_WORD_ORDER_ABCD;
+    ctx->state = MB_SLAVE_ONLINE;
+}
+
+
+/**
+ * @brief  用一个往返时间样本更新自适应应答超时
+ *
+ * 与 TCP RTO 相同的方法（RFC 6298）：平滑往返时间和偏差按 1/8、1/4 指数加权，
+ * 超时 = 平滑往返时间 + 4 倍偏差，限制在 [MB_BUS_RTO_MIN_MS, MB_BUS_RTO_MAX_MS]。
+ * 往返时间包含请求帧发送时间，得到的超时偏保守。
+ */
+static void modbus_bus_rtt_sample(mb_slave_ctx_t *ctx, int rtt_ms)
+{
+    if (ctx->srtt == 0)//首个样本
+    {
+        ctx->srtt = rtt_ms << 3;
+        ctx->rttvar = rtt_ms << 1;
+    }
+    else
+    {
+        int err = rtt_ms - (ctx->srtt >> 3);
+        ctx->srtt += err;//srtt += err/8 (放大8倍)
+        if (err < 0)
+        {
+            err = -err;
+        }
+        ctx->rttvar += err - (ctx->rttvar >> 2);//rttvar += (|err|-rttvar)/4 (放大4倍)
+    }
+
+    int rto = (ctx->srtt >> 3) + ctx->rttvar;
+    if (rto < MB_BUS_RTO_MIN_MS)
+    {
+        rto = MB_BUS_RTO_MIN_MS;
+    }
+    if (rto > MB_BUS_RTO_MAX_MS)
+    {
+        rto = MB_BUS_RTO_MAX_MS;
+    }
+    ctx->rto_ms = rto;
+}
+
+
+/**
+ * @brief  从机当前使用的应答超时
+ */
+static int modbus_bus_ack_tmo(const mb_bus_t *bus, const mb_slave_ctx_t *ctx)
+{
+    if (ctx->ack_tmo_ms > 0)
+    {
+        return(ctx->ack_tmo_ms);
+    }
+    return((ctx->rto_ms > 0) ? ctx->rto_ms : bus->ack_tmo_ms);
+}
+
+
+/**
+ * @brief  创建多从机总线
+ *
+ * 一条 RS-485 线路上挂多个从机时，实例只有一个从机地址，
+ * 每次请求前都要切换地址和超时。总线对象独占一个实例（后端），
+ * 每个从机一个上下文，各自保存超时、字序、统计和健康状态，
+ * 请求时自动切换，轮询时在从机间轮流执行。
+ *
+ * @param[in] type   后端类型
+ * @param[in] param  后端参数
+ *
+ * @return mb_bus_t*  成功返回总线指针，失败返回 NULL
+ *
+ * @note
+ *   - 总线只应在一个线程中使用，多线程访问时配合请求队列使用
+ */
+mb_bus_t *modbus_bus_create(mb_backend_type_t type, const mb_backend_param_t *param)
+{
+    mb_bus_t *bus = calloc(1, sizeof(mb_bus_t));
+    if (bus == NULL)
+    {
+        return(NULL);
+    }
+
+    bus->hinst = modbus_create(type, param);
+    if (bus->hinst == NULL)
+    {
+        free(bus);
+        return(NULL);
+    }
+
+    bus->ack_tmo_ms = bus->hinst->backend->ack_tmo_ms;
+    bus->byte_tmo_ms = bus->hinst->backend->byte_tmo_ms;
+
+    return(bus);
+}
+
+
+/**
+ * @brief  销毁多从机总线
+ *
+ * @param[in] bus  总线指针
+ */
+void modbus_bus_destroy(mb_bus_t *bus)
+{
+    if (bus == NULL)
+    {
+        return;
+    }
+
+    modbus_destroy(bus->hinst);
+    free(bus);
+}
+
+
+/**
+ * @brief  添加从机
+ *
+ * @param[in,out] bus  总线指针
+ * @param[in]     ctx  从机上下文（须先由 modbus_slave_ctx_init() 初始化）
+ *
+ * @return int
+ *   -  0 : 成功
+ *   - -1 : 从机已满或地址重复
+ */
+int modbus_bus_add_slave(mb_bus_t *bus, mb_slave_ctx_t *ctx)
+{
+    MB_ASSERT(bus != NULL);
+    MB_ASSERT(ctx != NULL);
+
+    if ((bus->num >= MB_BUS_SLAVE_MAX) || (modbus_bus_find(bus, ctx->saddr) != NULL))
+    {
+        return(-1);
+    }
+
+    bus->slave[bus->num++] = ctx;
+    return(0);
+}
+
+
+/**
+ * @brief  按从机地址查找上下文
+ *
+ * @return mb_slave_ctx_t*  找到返回上下文，否则返回 NULL
+ */
+mb_slave_ctx_t *modbus_bus_find(const mb_bus_t *bus, uint8_t saddr)
+{
+    MB_ASSERT(bus != NULL);
+
+    for (int i=0; i<bus->num; i++)
+    {
+        if (bus->slave[i]->saddr == saddr)
+        {
+            return(bus->slave[i]);
+        }
+    }
+    return(NULL);
+}
+
+
+/**
+ * @brief  根据请求结果更新从机统计和健康状态
+ */
+static void modbus_bus_account(mb_bus_t *bus, mb_slave_ctx_t *ctx, int rst, int rtt_ms)
+{
+    ctx->stat.req_cnt++;
+
+    if (rst == 0)//超时或通信失败
+    {
+        ctx->stat.tmo_cnt++;
+        ctx->fail_cnt++;
+
+        //超时加倍(不超过上限), 并按连续失败次数指数退避轮询
+        int rto = modbus_bus_ack_tmo(bus, ctx) * 2;
+        ctx->rto_ms = (rto > MB_BUS_RTO_MAX_MS) ? MB_BUS_RTO_MAX_MS : rto;
+        int shift = (ctx->fail_cnt > 16) ? 16 : (ctx->fail_cnt - 1);
+        long long hold = (long long)MB_BUS_BACKOFF_BASE_MS << shift;
+        if (hold > MB_BUS_BACKOFF_MAX_MS)
+        {
+            hold = MB_BUS_BACKOFF_MAX_MS;
+        }
+        ctx->hold_ms = modbus_port_get_ms() + hold;
+
+        //连续失败达到门限或探测失败时断开, 按探测间隔半开
+        if ((ctx->state == MB_SLAVE_PROBING)
+            || ((ctx->state == MB_SLAVE_ONLINE) && (ctx->fail_cnt >= MB_BUS_OFFLINE_FAILS)))
+        {
+            if (ctx->state == MB_SLAVE_ONLINE)
+            {
+                LOG_W("slave %d offline.", ctx->saddr);
+            }
+            ctx->state = MB_SLAVE_OFFLINE;
+            ctx->hold_ms = modbus_port_get_ms() + MB_BUS_PROBE_MS;
+        }
+        return;
+    }
+
+    //收到应答(含异常应答)说明从机在线
+    if (rst > 0)
+    {
+        ctx->stat.ok_cnt++;
+    }
+    else
+    {
+        ctx->stat.exc_cnt++;
+    }
+    ctx->stat.rtt_ms = rtt_ms;
+    if (rtt_ms > ctx->stat.rtt_max_ms)
+    {
+        ctx->stat.rtt_max_ms = rtt_ms;
+    }
+    modbus_bus_rtt_sample(ctx, rtt_ms);
+    ctx->fail_cnt = 0;
+    ctx->hold_ms = 0;
+    if (ctx->state != MB_SLAVE_ONLINE)
+    {
+        ctx->state = MB_SLAVE_ONLINE;
+        LOG_I("slave %d online.", ctx->saddr);
+    }
+}
+
+
+/**
+ * @brief  断路器检查，离线从机到达探测时间时转为探测状态
+ *
+ * @return int  允许访问总线返回 1，否则返回 0
+ */
+static int modbus_bus_allow(mb_slave_ctx_t *ctx, long long now)
+{
+    if (ctx->state != MB_SLAVE_OFFLINE)
+    {
+        return(1);
+    }
+    if (now < ctx->hold_ms)
+    {
+        return(0);
+    }
+
+    ctx->state = MB_SLAVE_PROBING;
+    LOG_D("slave %d probing.", ctx->saddr);
+    return(1);
+}
+
+
+/**
+ * @brief  以从机上下文执行一次请求
+ *
+ * 切换实例的从机地址和超时为上下文的配置后执行请求，
+ * 再按结果更新统计、健康状态和自适应应答超时。
+ * 未配置固定超时的从机按观测到的往返时间设置超时：快的从机超时收紧，
+ * 慢的从机不受影响；连续超时时超时加倍，且轮询按指数退避暂停。
+ * 每个从机带一个断路器：连续失败 MB_BUS_OFFLINE_FAILS 次后断开（离线），
+ * 离线期间请求直接失败不占用总线，每隔 MB_BUS_PROBE_MS 半开一次
+ * 放行一个探测请求，有应答（含异常应答）则恢复在线，否则继续离线。
+ *
+ * @param[in,out] bus    总线指针
+ * @param[in,out] ctx    从机上下文
+ * @param[in]     fc     功能码（0x01~0x06、0x0F、0x10）
+ * @param[in]     addr   起始地址
+ * @param[in]     nb     数量
+ * @param[in,out] pdata  数据，按功能码解释（同 modbus_master_call()）
+ *
+ * @return int  同对应的同步接口
+ */
+int modbus_bus_call(mb_bus_t *bus, mb_slave_ctx_t *ctx, uint8_t fc, uint16_t addr, int nb, void *pdata)
+{
+    MB_ASSERT(bus != NULL);
+    MB_ASSERT(ctx != NULL);
+
+    // 1. 离线且未到探测时间的从机直接失败, 不占用总线
+    long long told_ms = modbus_port_get_ms();
+    if ( ! modbus_bus_allow(ctx, told_ms))
+    {
+        ctx->stat.skip_cnt++;
+        return(0);
+    }
+
+    // 2. 切换到从机的超时配置
+    int ack_tmo_ms = modbus_bus_ack_tmo(bus, ctx);
+    int byte_tmo_ms = (ctx->byte_tmo_ms > 0) ? ctx->byte_tmo_ms : bus->byte_tmo_ms;
+    modbus_set_tmo(bus->hinst, ack_tmo_ms, byte_tmo_ms);
+
+    // 3. 执行请求并更新统计
+    int rst = modbus_master_call(bus->hinst, ctx->saddr, fc, addr, nb, pdata);
+    modbus_bus_account(bus, ctx, rst, (int)(modbus_port_get_ms() - told_ms));
+
+    return(rst);
+}
+
+
+/**
+ * @brief  按从机字序读取 32 位数据的原始字节
+ *
+ * @return int  成功返回 nb，失败同同步接口
+ */
+static int modbus_bus_read_raw32(mb_bus_t *bus, mb_slave_ctx_t *ctx, uint8_t fc, uint16_t addr, int nb, uint16_t *pregs)
+{
+    if ((fc != MODBUS_FC_READ_HOLDING_REGISTERS) && (fc != MODBUS_FC_READ_INPUT_REGISTERS))
+    {
+        return(-MODBUS_EC_ILLEGAL_FUNCTION);
+    }
+    if ((nb <= 0) || ((nb * 2) > MODBUS_READ_REG_MAX))
+    {
+        return(0);
+    }
+
+    int rst = modbus_bus_call(bus, ctx, fc, addr, nb * 2, pregs);
+    if (rst != nb * 2)
+    {
+        return(rst);
+    }
+
+    modbus_cvt_u16_put_block((uint8_t *)pregs, pregs, nb * 2);//还原为线路字节流, 再按字序转换
+    return(nb);
+}
+
+
+/**
+ * @brief  按从机字序读取 32 位无符号数（功能码 0x03 / 0x04）
+ *
+ * @param[in,out] bus    总线指针
+ * @param[in,out] ctx    从机上下文
+ * @param[in]     fc     功能码
+ * @param[in]     addr   起始地址
+ * @param[in]     nb     数值个数（1 ~ MODBUS_READ_REG_MAX/2）
+ * @param[out]    pvals  输出数值
+ *
+ * @return int  成功返回 nb，失败同同步接口
+ */
+int modbus_bus_read_u32(mb_bus_t *bus, mb_slave_ctx_t *ctx, uint8_t fc, uint16_t addr, int nb, uint32_t *pvals)
+{
+    MB_ASSERT(pvals != NULL);
+
+    uint16_t regs[MODBUS_READ_REG_MAX];
+    int rst = modbus_bus_read_raw32(bus, ctx, fc, addr, nb, regs);
+    if (rst > 0)
+    {
+        modbus_cvt_u32_get_block((const uint8_t *)regs, pvals, nb, ctx->order);
+    }
+    return(rst);
+}
+
+
+/**
+ * @brief  按从机字序读取浮点数（功能码 0x03 / 0x04）
+ *
+ * @return int  同 modbus_bus_read_u32()
+ */
+int modbus_bus_read_f32(mb_bus_t *bus, mb_slave_ctx_t *ctx, uint8_t fc, uint16_t addr, int nb, float *pvals)
+{
+    MB_ASSERT(pvals != NULL);
+
+    uint16_t regs[MODBUS_READ_REG_MAX];
+    int rst = modbus_bus_read_raw32(bus, ctx, fc, addr, nb, regs);
+    if (rst > 0)
+    {
+        modbus_cvt_f32_get_block((const uint8_t *)regs, pvals, nb, ctx->order);
+    }
+    return(rst);
+}
+
+
+/**
+ * @brief  总线轮询
+ *
+ * 从机间轮流执行：每次调用取下一个有轮询点的从机，执行它的下一个轮询点。
+ * 从机交错访问，一个无应答的从机每轮只占用一次应答超时，不会阻塞其它从机；
+ * 连续超时的从机在退避期内跳过，离线从机只在探测时间到达时访问一次。
+ * 在线程中循环调用即可，全部从机都在退避期内时睡眠到最早的退避截止时间（最多 100ms）。
+ *
+ * @param[in,out] bus  总线指针
+ *
+ * @return int  执行结果（同对应的同步接口），没有任何轮询点返回 0
+ */
+int modbus_bus_poll(mb_bus_t *bus)
+{
+    MB_ASSERT(bus != NULL);
+
+    long long now = modbus_port_get_ms();
+    long long wake = 0;
+    for (int n=0; n<bus->num; n++)
+    {
+        mb_slave_ctx_t *ctx = bus->slave[bus->cur];
+        bus->cur = (bus->cur + 1) % bus->num;
+        if ((ctx->points == NULL) || (ctx->num <= 0))
+        {
+            continue;
+        }
+        if (ctx->hold_ms > now)//退避中
+        {
+            if ((wake == 0) || (ctx->hold_ms < wake))
+            {
+                wake = ctx->hold_ms;
+            }
+            continue;
+        }
+
+        int idx = ctx->next;
+        ctx->next = (ctx->next + 1) % ctx->num;
+
+        const mb_bus_point_t *pt = &(ctx->points[idx]);
+        int rst = modbus_bus_call(bus, ctx, pt->fc, pt->addr, pt->nb, pt->pdata);
+        if (ctx->cb != NULL)
+        {
+            ctx->cb(ctx, idx, rst);
+        }
+        return(rst);
+    }
+
+    if (wake > 0)
+    {
+        int dly = (int)(wake - now);
+        modbus_port_delay_ms((dly > 100) ? 100 : dly);
+    }
+
+    return(0);
+}
+
+
+/**
+ * @brief  打印每个从机的状态和统计
+ *
+ * @param[in] bus  总线指针
+ */
+void modbus_bus_dump(const mb_bus_t *bus)
+{
+    MB_ASSERT(bus != NULL);
+
+    static const char *state_name[] = {"online", "offline", "probing"};
+
+    MB_PRINTF("slave state     req       ok      tmo      exc     skip  rtt/max  tmo\n");
+    for (int i=0; i<bus->num; i++)
+    {
+        const mb_slave_ctx_t *ctx = bus->slave[i];
+        MB_PRINTF("%5d %-7s %8u %8u %8u %8u %8u %4d/%-4d %4d\n",
+                  ctx->saddr, state_name[ctx->state],
+                  (unsigned)ctx->stat.req_cnt, (unsigned)ctx->stat.ok_cnt,
+                  (unsigned)ctx->stat.tmo_cnt, (unsigned)ctx->stat.exc_cnt, (unsigned)ctx->stat.skip_cnt,
+                  ctx->stat.rtt_ms, ctx->stat.rtt_max_ms, modbus_bus_ack_tmo(bus, ctx));
+    }
+}
+
+#endif
@@ -7,6 +7,27 @@
  */
 #include "bsp_sys.h"
 
+/*
+ * 字节交换: GCC/Clang 的内建函数在 Cortex-M4 上编译为单条 REV16/REV 指令,
+ * 在主机上编译为 bswap/rev 等指令; 其它编译器使用移位实现
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define MB_CVT_BSWAP32(x)   __builtin_bswap32(x)
+#elif defined(__CC_ARM)
+#define MB_CVT_BSWAP32(x)   __rev(x)
+#else
+#define MB_CVT_BSWAP32(x)   ((((x) & 0xFF000000UL) >> 24) | (((x) & 0x00FF0000UL) >> 8) | \
+                             (((x) & 0x0000FF00UL) << 8) | (((x) & 0x000000FFUL) << 24))
+#endif
+//32位字内两个半字分别交换字节, Cortex-M4 上编译为 REV16
+#define MB_CVT_REV16(x)     ((((x) & 0x00FF00FFUL) << 8) | (((x) >> 8) & 0x00FF00FFUL))
+
+#if (defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)) || defined(__ARM_BIG_ENDIAN)
+#define MB_CVT_HOST_BIG_ENDIAN  1
+#else
+#define MB_CVT_HOST_BIG_ENDIAN  0
+#endif
+
 
 
 /**
@@ -199,6 +220,188 @@ int modbus_cvt_f32_get(const uint8_t *buf, float *pval)
 }
 
 
+/**
+ * @brief  批量写入 16 位寄存器（大端序）
+ *
+ * 将 nb 个主机序寄存器值转换为 Modbus 大端字节流。
+ * 每个寄存器先读出再写回同一位置的 2 字节，因此 buf 与 pregs
+ * 可以是同一块内存（原地转换），批量回调的结果无需再拷贝一次。
+ *
+ * @param[out] buf    目标缓冲区（至少 nb×2 字节）
+ * @param[in]  pregs  寄存器数组（主机序）
+ * @param[in]  nb     寄存器数量
+ *
+ * @return int  写入的字节数（nb×2）
+ */
+int modbus_cvt_u16_put_block(uint8_t *buf, const uint16_t *pregs, int nb)
+{
+    #if MB_CVT_HOST_BIG_ENDIAN
+    memmove(buf, pregs, nb * 2);
+    #else
+    // 1. 每次处理两个寄存器, 一次 32 位读写加一次 REV16
+    int i = 0;
+    for (; i + 2 <= nb; i += 2)
+    {
+        uint32_t w;
+        memcpy(&w, pregs + i, 4);
+        w = MB_CVT_REV16(w);
+        memcpy(buf + 2 * i, &w, 4);
+    }
+
+    // 2. 剩余的单个寄存器
+    for (; i<nb; i++)
+    {
+        uint16_t val = pregs[i];
+        buf[2 * i] = (uint8_t)(val >> 8);
+        buf[2 * i + 1] = (uint8_t)val;
+    }
+    #endif
+    return(nb * 2);
+}
+
+
+/**
+ * @brief  批量读取 16 位寄存器（大端序）
+ *
+ * 将 Modbus 大端字节流转换为 nb 个主机序寄存器值，允许原地转换。
+ *
+ * @param[in]  buf    源缓冲区（至少 nb×2 字节）
+ * @param[out] pregs  寄存器数组（主机序），须 2 字节对齐
+ * @param[in]  nb     寄存器数量
+ *
+ * @return int  读取的字节数（nb×2）
+ */
+int modbus_cvt_u16_get_block(const uint8_t *buf, uint16_t *pregs, int nb)
+{
+    #if MB_CVT_HOST_BIG_ENDIAN
+    memmove(pregs, buf, nb * 2);
+    #else
+    int i = 0;
+    for (; i + 2 <= nb; i += 2)
+    {
+        uint32_t w;
+        memcpy(&w, buf + 2 * i, 4);
+        w = MB_CVT_REV16(w);
+        memcpy(pregs + i, &w, 4);
+    }
+    for (; i<nb; i++)
+    {
+        pregs[i] = ((uint16_t)buf[2 * i] << 8) | buf[2 * i + 1];
+    }
+    #endif
+    return(nb * 2);
+}
+
+
+/**
+ * @brief  将主机序 32 位值按字序转换为线路字节对应的内存字
+ *
+ * 返回值按主机序直接存入内存即得到线路字节流。
+ * 四种字序的变换都是自逆的，读取时使用同一变换。
+ */
+static inline uint32_t modbus_cvt_u32_order(uint32_t val, mb_word_order_t order)
+{
+    #if MB_CVT_HOST_BIG_ENDIAN
+    switch(order)
+    {
+    case MB_WORD_ORDER_CDAB : return((val << 16) | (val >> 16));
+    case MB_WORD_ORDER_BADC : return(MB_CVT_REV16(val));
+    case MB_WORD_ORDER_DCBA : return(MB_CVT_BSWAP32(val));
+    default : return(val);
+    }
+    #else
+    switch(order)
+    {
+    case MB_WORD_ORDER_CDAB : return(MB_CVT_REV16(val));
+    case MB_WORD_ORDER_BADC : return((val << 16) | (val >> 16));
+    case MB_WORD_ORDER_DCBA : return(val);
+    default : return(MB_CVT_BSWAP32(val));
+    }
+    #endif
+}
+
+
+/**
+ * @brief  批量转换 32 位数据（u32 与 f32 共用）
+ *
+ * 源和目标都按 4 字节一组经 memcpy 读写，不要求对齐，允许原地转换。
+ */
+static void modbus_cvt_u32_block(void *dst, const void *src, int nb, mb_word_order_t order)
+{
+    uint8_t *pd = (uint8_t *)dst;
+    const uint8_t *ps = (const uint8_t *)src;
+    for (int i=0; i<nb; i++)
+    {
+        uint32_t w;
+        memcpy(&w, ps + 4 * i, 4);
+        w = modbus_cvt_u32_order(w, order);
+        memcpy(pd + 4 * i, &w, 4);
+    }
+}
+
+
+/**
+ * @brief  批量写入 32 位无符号整数（按字序）
+ *
+ * 每个值占两个寄存器，字序由设备决定（见 mb_word_order_t）。
+ *
+ * @param[out] buf    目标缓冲区（至少 nb×4 字节）
+ * @param[in]  pvals  数据数组（主机序）
+ * @param[in]  nb     数据个数（寄存器数量为 nb×2）
+ * @param[in]  order  字序
+ *
+ * @return int  写入的字节数（nb×4）
+ */
+int modbus_cvt_u32_put_block(uint8_t *buf, const uint32_t *pvals, int nb, mb_word_order_t order)
+{
+    modbus_cvt_u32_block(buf, pvals, nb, order);
+    return(nb * 4);
+}
+
+
+/**
+ * @brief  批量读取 32 位无符号整数（按字序）
+ *
+ * @param[in]  buf    源缓冲区（至少 nb×4 字节）
+ * @param[out] pvals  数据数组（主机序）
+ * @param[in]  nb     数据个数
+ * @param[in]  order  字序
+ *
+ * @return int  读取的字节数（nb×4）
+ */
+int modbus_cvt_u32_get_block(const uint8_t *buf, uint32_t *pvals, int nb, mb_word_order_t order)
+{
+    modbus_cvt_u32_block(pvals, buf, nb, order);
+    return(nb * 4);
+}
+
+
+/**
+ * @brief  批量写入 32 位浮点数（IEEE 754，按字序）
+ *
+ * @return int  写入的字节数（nb×4）
+ *
+ * @warning 仅在 IEEE 754 平台有效
+ */
+int modbus_cvt_f32_put_block(uint8_t *buf, const float *pvals, int nb, mb_word_order_t order)
+{
+    modbus_cvt_u32_block(buf, pvals, nb, order);
+    return(nb * 4);
+}
+
+
+/**
+ * @brief  批量读取 32 位浮点数（IEEE 754，按字序）
+ *
+ * @return int  读取的字节数（nb×4）
+ */
+int modbus_cvt_f32_get_block(const uint8_t *buf, float *pvals, int nb, mb_word_order_t order)
+{
+    modbus_cvt_u32_block(pvals, buf, nb, order);
+    return(nb * 4);
+}
+
+
 /**
  * @brief  从位图中读取指定位的值
  *
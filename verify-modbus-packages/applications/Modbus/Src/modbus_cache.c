@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+
+#include "bsp_sys.h"
+
+#if (defined(MB_USING_CACHE) && defined(MB_USING_MASTER))
+
+#define DBG_TAG "mb.cache"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+
+/**
+ * @brief  创建主机读缓存
+ *
+ * 多个应用线程读取同一从机的同一组寄存器时，每次读取都是一次总线往返。
+ * 读缓存按（从机, 功能码, 地址范围）保存最近的应答：读者在可接受的数据年龄内
+ * 直接得到缓存数据；同一范围的并发未命中只有一个线程访问总线，其余线程等待
+ * 并共享该次结果（single-flight）。经实例发出的写请求自动使重叠区间失效。
+ *
+ * @param[in,out] hinst  Modbus 实例（主机）
+ *
+ * @return mb_cache_t*  成功返回缓存指针，失败返回 NULL
+ *
+ * @note
+ *   - 经缓存发出的请求由总线锁互斥，多线程共享实例时其它请求使用 modbus_cache_call()
+ */
+mb_cache_t *modbus_cache_create(mb_inst_t *hinst)
+{
+    if (hinst == NULL)
+    {
+        return(NULL);
+    }
+
+    mb_cache_t *cache = calloc(1, sizeof(mb_cache_t));
+    if (cache == NULL)
+    {
+        return(NULL);
+    }
+
+    cache->lock = rt_mutex_create("mbc_lk", RT_IPC_FLAG_PRIO);
+    cache->bus = rt_mutex_create("mbc_bus", RT_IPC_FLAG_PRIO);
+    cache->evt = rt_event_create("mbc_evt", RT_IPC_FLAG_PRIO);
+    if ((cache->lock == NULL) || (cache->bus == NULL) || (cache->evt == NULL))
+    {
+        LOG_E("cache ipc create fail.");
+        modbus_cache_destroy(cache);
+        return(NULL);
+    }
+
+    cache->hinst = hinst;
+    hinst->cache = cache;
+
+    return(cache);
+}
+
+
+/**
+ * @brief  销毁主机读缓存
+ *
+ * 须在没有线程经缓存访问时调用。
+ *
+ * @param[in] cache  缓存指针
+ */
+void modbus_cache_destroy(mb_cache_t *cache)
+{
+    if (cache == NULL)
+    {
+        return;
+    }
+
+    if ((cache->hinst != NULL) && (cache->hinst->cache == cache))
+    {
+        cache->hinst->cache = NULL;
+    }
+    if (cache->lock != NULL)
+    {
+        rt_mutex_delete(cache->lock);
+    }
+    if (cache->bus != NULL)
+    {
+        rt_mutex_delete(cache->bus);
+    }
+    if (cache->evt != NULL)
+    {
+        rt_event_delete(cache->evt);
+    }
+
+    free(cache);
+}
+
+
+/**
+ * @brief  缓存项是否包含 [addr, addr+nb)
+ */
+static int modbus_cache_cover(const mb_cache_entry_t *e, uint8_t saddr, uint8_t fc, uint16_t addr, int nb)
+{
+    return((e->saddr == saddr) && (e->fc == fc) && (addr >= e->addr)
+           && (((uint32_t)addr + nb) <= ((uint32_t)e->addr + e->nb)));
+}
+
+
+/**
+ * @brief  从缓存项拷贝 [addr, addr+nb) 到输出
+ */
+static void modbus_cache_copy(const mb_cache_entry_t *e, uint16_t addr, int nb, void *pdata)
+{
+    int off = addr - e->addr;
+
+    if ((e->fc == MODBUS_FC_READ_COILS) || (e->fc == MODBUS_FC_READ_DISCRETE_INPUTS))
+    {
+        uint8_t *pbits = (uint8_t *)pdata;
+        memset(pbits, 0, (nb + 7) / 8);
+        for (int i=0; i<nb; i++)
+        {
+            modbus_bitmap_set(pbits, i, modbus_bitmap_get((const uint8_t *)e->data, off + i));
+        }
+    }
+    else
+    {
+        memcpy(pdata, e->data + off, nb * sizeof(uint16_t));
+    }
+}
+
+
+/**
+ * @brief  选择用于加载的缓存项：空闲项优先，否则最久未更新的非加载项
+ *
+ * @return int  缓存项索引，全部在加载中返回 -1
+ */
+static int modbus_cache_victim(const mb_cache_t *cache)
+{
+    int idx = -1;
+    for (int i=0; i<MB_CACHE_ENTRY_MAX; i++)
+    {
+        const mb_cache_entry_t *e = &(cache->entry[i]);
+        if ( ! e->used)
+        {
+            return(i);
+        }
+        if ( ! e->loading)
+        {
+            if ((idx < 0) || (e->time_ms < cache->entry[idx].time_ms))
+            {
+                idx = i;
+            }
+        }
+    }
+    return(idx);
+}
+
+
+/**
+ * @brief  经缓存读取（功能码 0x01~0x04）
+ *
+ * @param[in,out] cache       缓存指针
+ * @param[in]     saddr       从机地址
+ * @param[in]     fc          功能码
+ * @param[in]     addr        起始地址
+ * @param[in]     nb          数量（不超过单帧上限）
+ * @param[out]    pdata       输出数据，位为低位在前的位表（uint8_t[]），寄存器为主机序（uint16_t[]）
+ * @param[in]     max_age_ms  可接受的最大数据年龄（毫秒），0 表示只与在途加载合并
+ *
+ * @return int  同对应的同步接口
+ *
+ * @note
+ *   - 命中条件：缓存项包含请求范围，数据年龄不超过 max_age_ms，且加载后未被写请求失效
+ *   - 请求范围被在途加载包含时等待该次加载完成并共享结果（含失败结果）
+ */
+int modbus_cache_read(mb_cache_t *cache, uint8_t saddr, uint8_t fc, uint16_t addr, int nb, void *pdata, int max_age_ms)
+{
+    MB_ASSERT(cache != NULL);
+    MB_ASSERT(pdata != NULL);
+
+    if ((fc != MODBUS_FC_READ_COILS) && (fc != MODBUS_FC_READ_DISCRETE_INPUTS)
+        && (fc != MODBUS_FC_READ_HOLDING_REGISTERS) && (fc != MODBUS_FC_READ_INPUT_REGISTERS))
+    {
+        return(-MODBUS_EC_ILLEGAL_FUNCTION);
+    }
+    int max = ((fc == MODBUS_FC_READ_COILS) || (fc == MODBUS_FC_READ_DISCRETE_INPUTS)) ? MODBUS_READ_BITS_MAX : MODBUS_READ_REG_MAX;
+    if ((nb <= 0) || (nb > max))
+    {
+        return(0);
+    }
+
+    mb_cache_entry_t *old = NULL;
+    rt_mutex_take(cache->lock, RT_WAITING_FOREVER);
+    while(1)
+    {
+        // 1. 查找新鲜的缓存数据或包含请求范围的在途加载
+        long long now = modbus_port_get_ms();
+        mb_cache_entry_t *join = NULL;
+        old = NULL;
+        for (int i=0; i<MB_CACHE_ENTRY_MAX; i++)
+        {
+            mb_cache_entry_t *e = &(cache->entry[i]);
+            if (( ! e->used) || ( ! modbus_cache_cover(e, saddr, fc, addr, nb)))
+            {
+                continue;
+            }
+            if (e->loading)
+            {
+                join = e;
+                continue;
+            }
+            if (( ! e->stale) && (e->rst > 0) && ((now - e->time_ms) <= max_age_ms))
+            {
+                modbus_cache_copy(e, addr, nb, pdata);
+                cache->hit_cnt++;
+                rt_mutex_release(cache->lock);
+                return(nb);
+            }
+            old = e;//过期或已失效, 加载时复用
+        }
+
+        // 2. 合并到在途加载, 等待完成后共享结果
+        if (join != NULL)
+        {
+            uint32_t bit = 1UL << (join - cache->entry);
+            uint32_t seq = join->seq;
+            cache->join_cnt++;
+            rt_mutex_release(cache->lock);
+            rt_event_recv(cache->evt, bit, RT_EVENT_FLAG_OR, RT_WAITING_FOREVER, NULL);
+            rt_mutex_take(cache->lock, RT_WAITING_FOREVER);
+            // 只接受所等待的这次加载的结果, 缓存项已被复用开始新的加载时重新查找
+            if ((join->seq == seq + 1) && ( ! join->loading) && modbus_cache_cover(join, saddr, fc, addr, nb))
+            {
+                int rst = join->rst;
+                if (rst > 0)
+                {
+                    modbus_cache_copy(join, addr, nb, pdata);
+                    rst = nb;
+                }
+                rt_mutex_release(cache->lock);
+                return(rst);
+            }
+            continue;//缓存项已被替换, 重新查找
+        }
+        break;
+    }
+
+    // 3. 未命中, 复用过期的同范围缓存项或占用一个缓存项加载; 全部在加载中时直接访问总线
+    cache->miss_cnt++;
+    int idx = (old != NULL) ? (int)(old - cache->entry) : modbus_cache_victim(cache);
+    if (idx < 0)
+    {
+        rt_mutex_release(cache->lock);
+        return(modbus_cache_call(cache, saddr, fc, addr, nb, pdata));
+    }
+
+    mb_cache_entry_t *e = &(cache->entry[idx]);
+    uint32_t bit = 1UL << idx;
+    e->used = 1;
+    e->loading = 1;
+    e->stale = 0;
+    e->saddr = saddr;
+    e->fc = fc;
+    e->addr = addr;
+    e->nb = nb;
+    rt_event_recv(cache->evt, bit, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, 0, NULL);
+    rt_mutex_release(cache->lock);
+
+    // 4. 加载期间不持有缓存表锁, 其它范围的读者可以继续命中
+    rt_mutex_take(cache->bus, RT_WAITING_FOREVER);
+    int rst = modbus_master_call(cache->hinst, saddr, fc, addr, nb, e->data);
+    rt_mutex_release(cache->bus);
+
+    // 5. 发布结果并唤醒等待者
+    rt_mutex_take(cache->lock, RT_WAITING_FOREVER);
+    e->rst = rst;
+    e->time_ms = modbus_port_get_ms();
+    e->loading = 0;
+    e->seq++;
+    if (rst > 0)
+    {
+        modbus_cache_copy(e, addr, nb, pdata);
+    }
+    else
+    {
+        e->used = 0;//失败结果只交给本次等待者, 不缓存
+    }
+    rt_mutex_release(cache->lock);
+    rt_event_send(cache->evt, bit);
+
+    return(rst);
+}
+
+
+/**
+ * @brief  经缓存的总线锁执行一次请求
+ *
+ * 写请求由主机写接口自动使缓存失效。
+ *
+ * @return int  同 modbus_master_call()
+ */
+int modbus_cache_call(mb_cache_t *cache, uint8_t saddr, uint8_t fc, uint16_t addr, int nb, void *pdata)
+{
+    MB_ASSERT(cache != NULL);
+
+    rt_mutex_take(cache->bus, RT_WAITING_FOREVER);
+    int rst = modbus_master_call(cache->hinst, saddr, fc, addr, nb, pdata);
+    rt_mutex_release(cache->bus);
+
+    return(rst);
+}
+
+
+/**
+ * @brief  使与写请求区间重叠的缓存项失效
+ *
+ * 线圈写（0x05/0x0F）影响 0x01 缓存，寄存器写（0x06/0x10/0x16/0x17）影响 0x03 缓存。
+ * 正在加载的缓存项标记为失效，加载结果仍交给本次等待者，但不再作为新鲜数据命中。
+ *
+ * @param[in,out] cache  缓存指针
+ * @param[in]     saddr  从机地址
+ * @param[in]     fc     写功能码
+ * @param[in]     addr   写起始地址
+ * @param[in]     nb     写数量
+ */
+void modbus_cache_invalidate(mb_cache_t *cache, uint8_t saddr, uint8_t fc, uint16_t addr, int nb)
+{
+    MB_ASSERT(cache != NULL);
+
+    uint8_t rd_fc;
+    switch(fc)
+    {
+    case MODBUS_FC_WRITE_SINGLE_COIL :
+    case MODBUS_FC_WRITE_MULTIPLE_COILS :
+        rd_fc = MODBUS_FC_READ_COILS;
+        break;
+    case MODBUS_FC_WRITE_SINGLE_REGISTER :
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
+    case MODBUS_FC_MASK_WRITE_REGISTER :
+    case MODBUS_FC_WRITE_AND_READ_REGISTERS :
+        rd_fc = MODBUS_FC_READ_HOLDING_REGISTERS;
+        break;
+    default:
+        return;
+    }
+
+    rt_mutex_take(cache->lock, RT_WAITING_FOREVER);
+    for (int i=0; i<MB_CACHE_ENTRY_MAX; i++)
+    {
+        mb_cache_entry_t *e = &(cache->entry[i]);
+        if (e->used && (e->saddr == saddr) && (e->fc == rd_fc)
+            && (e->addr < ((uint32_t)addr + nb)) && (addr < ((uint32_t)e->addr + e->nb)))
+        {
+            e->stale = 1;
+        }
+    }
+    rt_mutex_release(cache->lock);
+}
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+
+#include "bsp_sys.h"
+
+#if (defined(MB_USING_COALESCE) && defined(MB_USING_MASTER))
+
+#define DBG_TAG "mb.coalesce"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+
+/**
+ * @brief  功能码对应的单帧读取上限
+ *
+ * @return int  读功能码返回上限，其它功能码返回 0（不参与合并）
+ */
+static int modbus_coalesce_cap(uint8_t fc)
+{
+    switch(fc)
+    {
+    case MODBUS_FC_READ_COILS :
+    case MODBUS_FC_READ_DISCRETE_INPUTS :
+        return(MODBUS_READ_BITS_MAX);
+    case MODBUS_FC_READ_HOLDING_REGISTERS :
+    case MODBUS_FC_READ_INPUT_REGISTERS :
+        return(MODBUS_READ_REG_MAX);
+    default:
+        break;
+    }
+    return(0);
+}
+
+
+/**
+ * @brief  比较两个请求项的排序键（从机地址, 功能码, 起始地址）
+ */
+static int modbus_coalesce_cmp(const mb_read_item_t *a, const mb_read_item_t *b)
+{
+    if (a->saddr != b->saddr)
+    {
+        return((a->saddr < b->saddr) ? -1 : 1);
+    }
+    if (a->fc != b->fc)
+    {
+        return((a->fc < b->fc) ? -1 : 1);
+    }
+    if (a->addr != b->addr)
+    {
+        return((a->addr < b->addr) ? -1 : 1);
+    }
+    return(0);
+}
+
+
+/**
+ * @brief  把合并帧的数据拆分回一个请求项
+ *
+ * @param[in,out] item  请求项
+ * @param[in]     buf   合并帧数据（寄存器为 uint16_t[]，位为位表）
+ * @param[in]     base  合并帧起始地址
+ */
+static void modbus_coalesce_scatter(mb_read_item_t *item, const void *buf, uint16_t base)
+{
+    int off = item->addr - base;
+
+    if ((item->fc == MODBUS_FC_READ_COILS) || (item->fc == MODBUS_FC_READ_DISCRETE_INPUTS))
+    {
+        uint8_t *pbits = (uint8_t *)item->pdata;
+        memset(pbits, 0, (item->nb + 7) / 8);
+        for (int i=0; i<item->nb; i++)
+        {
+            modbus_bitmap_set(pbits, i, modbus_bitmap_get((const uint8_t *)buf, off + i));
+        }
+    }
+    else
+    {
+        memcpy(item->pdata, (const uint16_t *)buf + off, item->nb * sizeof(uint16_t));
+    }
+}
+
+
+/**
+ * @brief  合并读取
+ *
+ * 应用的多个读点常映射到同一从机的相邻寄存器，逐个发送小请求时
+ * 每帧的地址、功能码、CRC 和 t3.5 间隔开销占主导（9600bps 下尤为明显）。
+ * 本接口把同一从机、同一功能码且地址重叠或相距不超过 gap 的请求项
+ * 合并为一帧（不超过 MODBUS_READ_REG_MAX/MODBUS_READ_BITS_MAX），
+ * 应答数据再拆分回各请求项。
+ *
+ * @param[in,out] hinst  Modbus 实例指针
+ * @param[in,out] items  请求项表（表本身不重排，结果写入各项的 pdata 和 rst）
+ * @param[in]     num    请求项数量
+ * @param[in]     gap    允许合并的最大地址间隙（寄存器或位），<0 使用 MB_COALESCE_GAP_DEF
+ *
+ * @return int  成功的请求项数
+ *
+ * @note
+ *   - 合并帧以异常应答时（如间隙中有未映射的地址），组内各项退回逐个请求
+ *   - 非读功能码的项不参与合并，按 modbus_master_call() 单独执行
+ *   - 执行后实例的从机地址为最后一个请求项的从机地址
+ */
+int modbus_coalesce_read(mb_inst_t *hinst, mb_read_item_t *items, int num, int gap)
+{
+    MB_ASSERT(hinst != NULL);
+    MB_ASSERT(items != NULL);
+
+    if (num <= 0)
+    {
+        return(0);
+    }
+    if (gap < 0)
+    {
+        gap = MB_COALESCE_GAP_DEF;
+    }
+
+    // 1. 按(从机地址, 功能码, 起始地址)对索引插入排序
+    uint16_t *idx = malloc(num * sizeof(uint16_t));
+    if (idx == NULL)
+    {
+        return(0);
+    }
+    for (int i=0; i<num; i++)
+    {
+        int j = i - 1;
+        while((j >= 0) && (modbus_coalesce_cmp(&(items[idx[j]]), &(items[i])) > 0))
+        {
+            idx[j + 1] = idx[j];
+            j--;
+        }
+        idx[j + 1] = i;
+    }
+
+    union{
+        uint16_t regs[MODBUS_READ_REG_MAX];
+        uint8_t  bits[(MODBUS_READ_BITS_MAX + 7) / 8];
+    }buf;
+    int ok = 0;
+    int i = 0;
+    while(i < num)
+    {
+        // 2. 向后扩展合并组 [i, j), 组覆盖地址 [lo, hi)
+        mb_read_item_t *first = &(items[idx[i]]);
+        int cap = modbus_coalesce_cap(first->fc);
+        uint32_t lo = first->addr;
+        uint32_t hi = lo + first->nb;
+        int j = i + 1;
+        while((cap > 0) && (j < num))
+        {
+            mb_read_item_t *it = &(items[idx[j]]);
+            uint32_t end = (uint32_t)it->addr + it->nb;
+            if ((it->saddr != first->saddr) || (it->fc != first->fc)
+                || (it->addr > hi + gap) || (((end > hi) ? end : hi) - lo > (uint32_t)cap))
+            {
+                break;
+            }
+            if (end > hi)
+            {
+                hi = end;
+            }
+            j++;
+        }
+
+        // 3. 单项直接读入请求项, 多项读入合并缓冲区后拆分
+        int rst = 0;
+        if (j - i > 1)
+        {
+            rst = modbus_master_call(hinst, first->saddr, first->fc, (uint16_t)lo, (int)(hi - lo), &buf);
+            LOG_D("slave %d fc %d merge %d items into [%d, %d), rst = %d.", first->saddr, first->fc, j - i, (int)lo, (int)hi, rst);
+        }
+        for (int k=i; k<j; k++)
+        {
+            mb_read_item_t *it = &(items[idx[k]]);
+            if (j - i == 1)
+            {
+                it->rst = modbus_master_call(hinst, it->saddr, it->fc, it->addr, it->nb, it->pdata);
+            }
+            else if (rst > 0)
+            {
+                modbus_coalesce_scatter(it, &buf, (uint16_t)lo);
+                it->rst = it->nb;
+            }
+            else if (rst < 0)//合并帧异常应答, 退回逐个请求
+            {
+                it->rst = modbus_master_call(hinst, it->saddr, it->fc, it->addr, it->nb, it->pdata);
+            }
+            else
+            {
+                it->rst = 0;
+            }
+            if (it->rst > 0)
+            {
+                ok++;
+            }
+        }
+
+        i = j;
+    }
+
+    free(idx);
+    return(ok);
+}
+
+#endif
@@ -11,7 +11,7 @@
 
 
 
-static const uint16_t modbus_crc_table[] = {
+const uint16_t modbus_crc_table[256] = {
     0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
     0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
     0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
@@ -46,7 +46,10 @@ static const uint16_t modbus_crc_table[] = {
     0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
 };
 
-uint16_t modbus_crc_cyc_cal(uint16_t init, const uint8_t *pdata, int len)
+/**
+ * @brief  单表逐字节计算 CRC16
+ */
+static uint16_t modbus_crc_cal_table(uint16_t init, const uint8_t *pdata, int len)
 {
     uint16_t crc = init;
     for(int i=0; i<len; i++)
@@ -58,22 +61,191 @@ uint16_t modbus_crc_cyc_cal(uint16_t init, const uint8_t *pdata, int len)
     return(crc);
 }
 
-uint16_t modbus_crc_cal(const uint8_t *pdata, int len)
+
+#if ((MB_CRC_ENGINE != MB_CRC_ENGINE_TABLE) || defined(MB_USING_CRC_BENCH))
+
+#define MB_CRC_SLICE_NUM    7   //slicing-by-8 需要 T1~T7, slicing-by-4 只用 T1~T3
+
+static uint16_t modbus_crc_slice_table[MB_CRC_SLICE_NUM][256];
+static volatile int modbus_crc_slice_ready = 0;
+
+
+/**
+ * @brief  生成 slicing 表
+ *
+ * Tk[i] 为字节 i 之后再经过 k 个零字节的 CRC 余数：
+ * Tk[i] = (Tk-1[i] >> 8) ^ T0[Tk-1[i] & 0xFF]。
+ * 首次使用时生成，生成结果与调用者无关，并发生成也不会出错。
+ */
+static void modbus_crc_slice_init(void)
 {
-    return(modbus_crc_cyc_cal(MB_CRC_INIT_VOL, pdata, len));
+    for (int i=0; i<256; i++)
+    {
+        uint16_t crc = modbus_crc_table[i];
+        for (int k=0; k<MB_CRC_SLICE_NUM; k++)
+        {
+            crc = (crc >> 8) ^ modbus_crc_table[crc & 0xFF];
+            modbus_crc_slice_table[k][i] = crc;
+        }
+    }
+    modbus_crc_slice_ready = 1;
 }
 
 
+/**
+ * @brief  slicing-by-4 计算 CRC16
+ *
+ * 每次读入 4 字节，4 次独立查表后异或合并，消除逐字节查表的串行依赖。
+ */
+static uint16_t modbus_crc_cal_slice4(uint16_t init, const uint8_t *pdata, int len)
+{
+    if (!modbus_crc_slice_ready)
+    {
+        modbus_crc_slice_init();
+    }
 
+    const uint16_t (*t)[256] = modbus_crc_slice_table;
+    uint16_t crc = init;
+    while (len >= 4)
+    {
+        uint16_t w = crc ^ (pdata[0] | ((uint16_t)pdata[1] << 8));
+        crc = t[2][w & 0xFF] ^ t[1][w >> 8] ^ t[0][pdata[2]] ^ modbus_crc_table[pdata[3]];
+        pdata += 4;
+        len -= 4;
+    }
 
+    return(modbus_crc_cal_table(crc, pdata, len));
+}
 
 
+/**
+ * @brief  slicing-by-8 计算 CRC16
+ */
+static uint16_t modbus_crc_cal_slice8(uint16_t init, const uint8_t *pdata, int len)
+{
+    if (!modbus_crc_slice_ready)
+    {
+        modbus_crc_slice_init();
+    }
 
+    const uint16_t (*t)[256] = modbus_crc_slice_table;
+    uint16_t crc = init;
+    while (len >= 8)
+    {
+        uint16_t w = crc ^ (pdata[0] | ((uint16_t)pdata[1] << 8));
+        crc = t[6][w & 0xFF] ^ t[5][w >> 8] ^ t[4][pdata[2]] ^ t[3][pdata[3]]
+            ^ t[2][pdata[4]] ^ t[1][pdata[5]] ^ t[0][pdata[6]] ^ modbus_crc_table[pdata[7]];
+        pdata += 8;
+        len -= 8;
+    }
 
+    return(modbus_crc_cal_slice4(crc, pdata, len));
+}
 
+#endif
 
 
+/**
+ * @brief  计算 CRC16（可分段连续计算）
+ *
+ * 使用 MB_CRC_ENGINE 选择的引擎，结果与引擎无关。
+ *
+ * @param[in] init   初始值（首段为 MB_CRC_INIT_VOL，后续段为上一段结果）
+ * @param[in] pdata  数据
+ * @param[in] len    数据长度
+ *
+ * @return uint16_t  CRC16（低字节先发送）
+ */
+uint16_t modbus_crc_cyc_cal(uint16_t init, const uint8_t *pdata, int len)
+{
+    #if (MB_CRC_ENGINE == MB_CRC_ENGINE_SLICE8)
+    return(modbus_crc_cal_slice8(init, pdata, len));
+    #elif (MB_CRC_ENGINE == MB_CRC_ENGINE_SLICE4)
+    return(modbus_crc_cal_slice4(init, pdata, len));
+    #else
+    return(modbus_crc_cal_table(init, pdata, len));
+    #endif
+}
+
+uint16_t modbus_crc_cal(const uint8_t *pdata, int len)
+{
+    return(modbus_crc_cyc_cal(MB_CRC_INIT_VOL, pdata, len));
+}
+
+
+#ifdef MB_USING_CRC_BENCH
+/*
+ * 计时: 有 DWT 时使用内核周期计数器, 否则使用系统节拍(精度较低, 按次数平均)
+ */
+#if defined(DWT) && defined(CoreDebug)
+#define MB_CRC_BENCH_UNIT   "cycles"
+static void modbus_crc_bench_start(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+static uint32_t modbus_crc_bench_now(void)
+{
+    return(DWT->CYCCNT);
+}
+#define MB_CRC_BENCH_ITER   1000
+#else
+#define MB_CRC_BENCH_UNIT   "ns"
+static void modbus_crc_bench_start(void)
+{
+}
+static uint32_t modbus_crc_bench_now(void)
+{
+    return(rt_tick_get() * (1000000000UL / RT_TICK_PER_SECOND));
+}
+#define MB_CRC_BENCH_ITER   20000
+#endif
+
+typedef uint16_t (*modbus_crc_engine_t)(uint16_t init, const uint8_t *pdata, int len);
 
 
+/**
+ * @brief  CRC 引擎性能测试
+ *
+ * 对 8~256 字节的帧分别用三种引擎计算，输出每帧平均耗时并校验结果一致。
+ * 用法：mb_crc_bench
+ */
+static void mb_crc_bench(void)
+{
+    static const modbus_crc_engine_t engine[] = {modbus_crc_cal_table, modbus_crc_cal_slice4, modbus_crc_cal_slice8};
+    static const char *name[] = {"table", "slice4", "slice8"};
+    static const int size[] = {8, 16, 32, 64, 128, 256};
+    static uint8_t buf[256];
 
+    for (size_t i=0; i<sizeof(buf); i++)
+    {
+        buf[i] = (uint8_t)(i * 131 + 7);
+    }
+    modbus_crc_slice_init();
+    modbus_crc_bench_start();
 
+    rt_kprintf("size");
+    for (size_t e=0; e<sizeof(name)/sizeof(name[0]); e++)
+    {
+        rt_kprintf(" %8s", name[e]);
+    }
+    rt_kprintf("  (%s/frame)\n", MB_CRC_BENCH_UNIT);
+    for (size_t s=0; s<sizeof(size)/sizeof(size[0]); s++)
+    {
+        uint32_t cost[3];
+        uint16_t crc[3];
+        for (size_t e=0; e<3; e++)
+        {
+            uint32_t t0 = modbus_crc_bench_now();
+            for (int n=0; n<MB_CRC_BENCH_ITER; n++)
+            {
+                crc[e] = engine[e](MB_CRC_INIT_VOL, buf, size[s]);
+            }
+            cost[e] = (modbus_crc_bench_now() - t0) / MB_CRC_BENCH_ITER;
+        }
+        rt_kprintf("%4d %8u %8u %8u  %s\n", size[s], (unsigned int)cost[0], (unsigned int)cost[1], (unsigned int)cost[2],
+                   ((crc[0] == crc[1]) && (crc[0] == crc[2])) ? "ok" : "MISMATCH");
+    }
+}
+MSH_CMD_EXPORT(mb_crc_bench, modbus crc16 engine benchmark);
+#endif
@@ -21,8 +21,8 @@
  * 便于查看帧结构、校验码、功能码等信息。仅在宏 #MB_USING_RAW_PRT 被定义时生效。
  *
  * @param[in] is_send  数据方向标识
- *                     - true  : 发送数据（打印前缀 ">>"）
- *                     - false : 接收数据（打印前缀 "<<"）
+ *                     - 1 : 发送数据（打印前缀 ">>"）
+ *                     - 0 : 接收数据（打印前缀 "<<"）
  * @param[in] pdata    指向待打印数据的缓冲区首地址
  * @param[in] dlen     数据长度（字节数），必须大于 0
  *
@@ -33,7 +33,7 @@
  *   - 若 #MB_USING_RAW_PRT 未定义，函数将不会被编译，节省资源
  *   - 调用前应确保 pdata 不为 NULL 且 dlen 合法，否则可能引发未定义行为
  */
-static void modbus_raw_printf(bool is_send, const u8 *pdata, int dlen)
+void modbus_raw_printf(int is_send, const uint8_t *pdata, int dlen)
 {
     MB_PRINTF("%s", is_send ? ">>" : "<<");
     for (int i=0; i<dlen; i++)
@@ -112,6 +112,15 @@ mb_inst_t * modbus_create(mb_backend_type_t type, const mb_backend_param_t *para
     #else
     hinst->cb = NULL;
     #endif
+    #ifdef MB_USING_REGBANK
+    hinst->bank = NULL;
+    #endif
+    #if (defined(MB_USING_CACHE) && defined(MB_USING_MASTER))
+    hinst->cache = NULL;
+    #endif
+    #ifdef MB_USING_RTU_ISR_CRC
+    hinst->rx_crc = -1;
+    #endif
 
     return(hinst);
 }
@@ -313,7 +322,92 @@ int modbus_recv(mb_inst_t *hinst, uint8_t *buf, int bufsize)
     #ifdef MB_USING_RAW_PRT
     if (len > 0)
     {
-        modbus_raw_prt(false, buf, len);
+        modbus_raw_printf(0, buf, len);
+    }
+    #endif
+
+    return(len);
+}
+
+
+/**
+ * @brief  接收一帧 Modbus 数据（按功能码预测帧长度）
+ *
+ * 与 modbus_recv() 相同，但根据协议类型提供帧长度预测函数，
+ * 功能码和字节计数到达后即可确定帧长度，最后一个字节到达时立即返回，
+ * 省去每帧末尾的字节间超时等待。
+ *
+ * @param[in,out] hinst    Modbus 实例指针
+ * @param[out]    buf      接收数据缓冲区
+ * @param[in]     bufsize  缓冲区大小（字节）
+ * @param[in]     type     期望的帧类型（主站收响应 MB_PDU_TYPE_RSP，从站收请求 MB_PDU_TYPE_REQ）
+ *
+ * @retval >0  成功接收的字节数
+ * @retval  0  超时（无数据）
+ * @retval -1  接收错误（连接断开、硬件故障等）
+ *
+ * @note
+ *   - RTU 按功能码预测，功能码不支持时退回到超时断帧
+ *   - TCP 按 MBAP 长度字段切帧，粘包的后续帧保留到下次接收
+ *   - 错误时自动调用 mb_backend_close()
+ */
+int modbus_recv_frame(mb_inst_t *hinst, uint8_t *buf, int bufsize, mb_pdu_type_t type)
+{
+    MB_ASSERT(hinst != NULL);
+    MB_ASSERT(hinst->backend != NULL);
+
+    return(modbus_recv_frame_tmo(hinst, buf, bufsize, type, hinst->backend->ack_tmo_ms));
+}
+
+
+/**
+ * @brief  接收一帧 Modbus 数据，应答超时由参数指定
+ *
+ * 与 modbus_recv_frame() 相同，不修改实例配置的超时，
+ * 用于流水线按最早到期事务的剩余时间等待。
+ *
+ * @param[in] tmo_ms  本次等待首字节的最长时间（毫秒），0 表示不等待
+ *
+ * @return int  同 modbus_recv_frame()
+ */
+int modbus_recv_frame_tmo(mb_inst_t *hinst, uint8_t *buf, int bufsize, mb_pdu_type_t type, int tmo_ms)
+{
+    MB_ASSERT(hinst != NULL);
+    MB_ASSERT(hinst->backend != NULL);
+    MB_ASSERT(buf != NULL);
+    MB_ASSERT(bufsize > 0);
+
+    modbus_bkd_frm_len_t frm_len = NULL;
+    switch(hinst->prototype)
+    {
+    #ifdef MB_USING_RTU_PROTOCOL
+    case MB_PROT_RTU :
+        frm_len = modbus_rtu_frame_len;
+        break;
+    #endif
+    #ifdef MB_USING_TCP_PROTOCOL
+    case MB_PROT_TCP :
+        frm_len = modbus_tcp_frm_len;
+        break;
+    #endif
+    default:
+        break;
+    }
+
+    int len = modbus_backend_read_frame_tmo(hinst->backend, buf, bufsize, frm_len, (int)type, tmo_ms);
+    if (len < 0)//发生错误, 关闭后端
+    {
+        modbus_backend_close(hinst->backend);
+    }
+
+    #ifdef MB_USING_RTU_ISR_CRC
+    hinst->rx_crc = (len > 0) ? modbus_backend_rx_crc(hinst->backend, len) : -1;
+    #endif
+
+    #ifdef MB_USING_RAW_PRT
+    if (len > 0)
+    {
+        modbus_raw_printf(0, buf, len);
     }
     #endif
 
@@ -354,7 +448,7 @@ int modbus_send(mb_inst_t *hinst, uint8_t *buf, int size)
     #ifdef MB_USING_RAW_PRT
     if (len > 0)
     {
-        modbus_raw_prt(true, buf, len);
+        modbus_raw_printf(1, buf, len);
     }
     #endif
 
@@ -384,3 +478,92 @@ int modbus_flush(mb_inst_t *hinst)
 }
 
 
+/**
+ * @brief  丢弃接收数据直到总线静默
+ *
+ * RTU 总线冲突或噪声后，缓冲区中的数据和仍在到达的半帧都不可用，
+ * 清空后等待总线静默，使下一次接收从新帧的首字节开始。
+ *
+ * @param[in,out] hinst       Modbus 实例指针
+ * @param[in]     silence_ms  静默时间（毫秒），<=0 时使用字节超时
+ *
+ * @retval >=0  丢弃的字节数
+ * @retval  -1  失败（设备未打开等）
+ *
+ * @note
+ *   - 最长等待应答超时时间，总线一直繁忙时到时返回
+ */
+int modbus_discard(mb_inst_t *hinst, int silence_ms)
+{
+    MB_ASSERT(hinst != NULL);
+    MB_ASSERT(hinst->backend != NULL);
+
+    return(modbus_backend_discard(hinst->backend, silence_ms, hinst->backend->ack_tmo_ms));
+}
+
+
+
+
+/**
+ * @brief  零拷贝编码：取收发缓冲区中 PDU 的起始位置
+ *
+ * 帧头（RTU 从机地址或 TCP MBAP 头）的空间已预留，调用者在返回位置
+ * 直接写入 PDU（含寄存器数据），再由 modbus_frame_seal() 封装，
+ * 省去先写入 hinst->datas 再拷贝到 hinst->buf 的中间环节。
+ *
+ * @param[in] hinst  Modbus 实例指针
+ *
+ * @return uint8_t*  PDU 起始位置，最多可写 MB_PDU_SIZE_MAX 字节
+ */
+uint8_t *modbus_frame_pdu(mb_inst_t *hinst)
+{
+    MB_ASSERT(hinst != NULL);
+
+    #ifdef MB_USING_TCP_PROTOCOL
+    if (hinst->prototype == MB_PROT_TCP)
+    {
+        return(hinst->buf + MB_TCP_MBAP_SIZE);
+    }
+    #endif
+
+    return(hinst->buf + MB_RTU_SADDR_SIZE);
+}
+
+
+/**
+ * @brief  零拷贝编码：封装已写入的请求 PDU
+ *
+ * RTU 填写从机地址并原地追加 CRC；TCP 分配新的事务标识并填写 MBAP 头。
+ *
+ * @param[in,out] hinst    Modbus 实例指针
+ * @param[in]     pdu_len  已写入的 PDU 长度
+ *
+ * @return int  帧长度，可直接以 modbus_send(hinst, hinst->buf, 帧长度) 发送，协议不支持返回 0
+ */
+int modbus_frame_seal(mb_inst_t *hinst, int pdu_len)
+{
+    MB_ASSERT(hinst != NULL);
+
+    switch(hinst->prototype)
+    {
+    #ifdef MB_USING_RTU_PROTOCOL
+    case MB_PROT_RTU :
+        return(modbus_rtu_frame_seal(hinst->buf, hinst->saddr, pdu_len));
+    #endif
+    #ifdef MB_USING_TCP_PROTOCOL
+    case MB_PROT_TCP :
+    {
+        mb_tcp_mbap_t mbap;
+        hinst->tsid++;
+        mbap.tid = hinst->tsid;
+        mbap.pid = MB_TCP_MBAP_PID;
+        mbap.did = hinst->saddr;
+        return(modbus_tcp_frm_seal(hinst->buf, &mbap, pdu_len));
+    }
+    #endif
+    default:
+        break;
+    }
+
+    return(0);
+}
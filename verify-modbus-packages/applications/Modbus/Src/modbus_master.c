@@ -11,6 +11,20 @@
 
 #ifdef MB_USING_MASTER
 
+/**
+ * @brief  发送 hinst->buf 中的同步请求帧
+ *
+ * 发送前清空接收缓冲区及后端保留的半帧，
+ * 防止上一次超时请求迟到的应答被当作本次请求的应答。
+ *
+ * @return int  同 modbus_send()
+ */
+static int modbus_master_send(mb_inst_t *hinst, int flen)
+{
+    modbus_flush(hinst);
+    return(modbus_send(hinst, hinst->buf, flen));
+}
+
 #ifdef MB_USING_RTU_PROTOCOL
 
 /**
@@ -46,17 +60,17 @@ static int modbus_read_req_rtu(mb_inst_t *hinst, uint8_t func, uint16_t addr, in
     // 2. 数据帧打包
     int flen = modbus_rtu_frame_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
     // 3. 通过rs485串口发送
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen){
         return(0);
     }
     // 4. 接收从机应答数据包
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0){
         return(0);
     }
     // 5. 解析RTU帧
-    int pdu_len = modbus_rtu_frame_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
+    int pdu_len = modbus_rtu_frame_parse_crc(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP, modbus_rx_crc(hinst));
     if (pdu_len <= 0)
     {
         return(0);
@@ -74,7 +88,12 @@ static int modbus_read_req_rtu(mb_inst_t *hinst, uint8_t func, uint16_t addr, in
         return(-(int)frm.pdu.exc.ec);
     }
 
+    //功能码或字节计数与请求不符时丢弃, 防止写出pdata
     int dlen = frm.pdu.rd_rsp.dlen;
+    if ((frm.pdu.fc != func) || (dlen != modbus_pdu_data_len(func, nb)))
+    {
+        return(0);
+    }
     memcpy(pdata, frm.pdu.rd_rsp.pdata, dlen);
 
     return(dlen);
@@ -96,20 +115,20 @@ static int modbus_read_req_tcp(mb_inst_t *hinst, uint8_t func, uint16_t addr, in
     frm.pdu.rd_req.nb = nb;
     
     int flen = modbus_tcp_frm_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen)
     {
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0)
     {
         return(0);
     }
     
     int pdu_len = modbus_tcp_frm_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
-    if (pdu_len < 0)
+    if (pdu_len <= 0)
     {
         return(0);
     }
@@ -133,7 +152,12 @@ static int modbus_read_req_tcp(mb_inst_t *hinst, uint8_t func, uint16_t addr, in
         return(-(int)frm.pdu.exc.ec);
     }
 
+    //功能码或字节计数与请求不符时丢弃, 防止写出pdata
     int dlen = frm.pdu.rd_rsp.dlen;
+    if ((frm.pdu.fc != func) || (dlen != modbus_pdu_data_len(func, nb)))
+    {
+        return(0);
+    }
     memcpy(pdata, frm.pdu.rd_rsp.pdata, dlen);
 
     return(dlen);
@@ -142,6 +166,48 @@ static int modbus_read_req_tcp(mb_inst_t *hinst, uint8_t func, uint16_t addr, in
 
 
 
+/**
+ * @brief  写请求完成后通知读缓存使对应区间失效
+ *
+ * 无论结果如何都使之失效：超时的写请求也可能已被从机执行。
+ */
+static void modbus_master_written(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb)
+{
+    #ifdef MB_USING_CACHE
+    if (hinst->cache != NULL)
+    {
+        modbus_cache_invalidate(hinst->cache, hinst->saddr, func, addr, nb);
+    }
+    #endif
+}
+
+
+/**
+ * @brief  功能码对应的单帧数量上限
+ *
+ * @return int  读写多个功能码返回协议规定的上限，其它功能码返回 0
+ */
+static int modbus_nb_max(uint8_t func)
+{
+    switch(func)
+    {
+    case MODBUS_FC_READ_COILS :
+    case MODBUS_FC_READ_DISCRETE_INPUTS :
+        return(MODBUS_READ_BITS_MAX);
+    case MODBUS_FC_READ_HOLDING_REGISTERS :
+    case MODBUS_FC_READ_INPUT_REGISTERS :
+        return(MODBUS_READ_REG_MAX);
+    case MODBUS_FC_WRITE_MULTIPLE_COILS :
+        return(MODBUS_WRITE_BITS_MAX);
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
+        return(MODBUS_WRITE_REG_MAX);
+    default:
+        break;
+    }
+    return(0);
+}
+
+
 /**
  * @brief  统一读操作接口（支持 RTU 和 TCP）
  *
@@ -169,6 +235,11 @@ int modbus_read_req(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, uint8
     MB_ASSERT(pdata != NULL);
     MB_ASSERT(nb > 0);
 
+    if (nb > modbus_nb_max(func))//超出单帧上限, 大范围读取使用modbus_read_range()
+    {
+        return(0);
+    }
+
     switch (hinst->prototype)
     {
         #ifdef MB_USING_RTU_PROTOCOL
@@ -189,45 +260,32 @@ int modbus_read_req(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, uint8
 #ifdef MB_USING_RTU_PROTOCOL
 
 /**
- * @brief  RTU 主站执行写多个操作（功能码 0x0F / 0x10）
+ * @brief  RTU 主站发送已封装的写多个请求并处理响应（功能码 0x0F / 0x10）
  *
- * 封装发送写请求、接收响应、解析、异常处理全流程。
- * 支持写多个线圈（0x0F）和写多个保持寄存器（0x10）。
+ * 请求帧已由调用者直接编码在 hinst->buf 中，本函数负责发送、接收响应、解析、异常处理。
  *
  * @param[in] hinst  实例指针
- * @param[in] func   功能码 (0x0F: 写线圈, 0x10: 写寄存器)
- * @param[in] addr   起始地址
- * @param[in] nb     数量（位或寄存器）
- * @param[in] pdata  输入数据（字节流，大端序）
- * @param[in] dlen   数据字节数（nb×1 或 nb×2）
+ * @param[in] flen   请求帧长度
  *
  * @return int
  *   - >0 : 成功写入的数量
  *   -  0 : 通信失败
  *   - <0 : 异常响应（-异常码）
  */
-static int modbus_write_req_rtu(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, const uint8_t *pdata, int dlen)
+static int modbus_write_xfer_rtu(mb_inst_t *hinst, int flen)
 {
     mb_rtu_frm_t frm;
-    frm.saddr = hinst->saddr;
-    frm.pdu.wr_req.fc = func;
-    frm.pdu.wr_req.addr = addr;
-    frm.pdu.wr_req.nb = nb;
-    frm.pdu.wr_req.dlen = dlen;
-    frm.pdu.wr_req.pdata = (uint8_t *)pdata;
-    
-    int flen = modbus_rtu_frame_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen){
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0){
         return(0);
     }
     
-    int pdu_len = modbus_rtu_frame_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
+    int pdu_len = modbus_rtu_frame_parse_crc(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP, modbus_rx_crc(hinst));
     if (pdu_len <= 0){
         return(0);
     }
@@ -249,34 +307,23 @@ static int modbus_write_req_rtu(mb_inst_t *hinst, uint8_t func, uint16_t addr, i
 #endif
 
 #ifdef MB_USING_TCP_PROTOCOL
-static int modbus_write_req_tcp(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, const uint8_t *pdata, int dlen)
+static int modbus_write_xfer_tcp(mb_inst_t *hinst, int flen)
 {
     mb_tcp_frm_t frm;
-    hinst->tsid++;
-    frm.mbap.tid = hinst->tsid;
-    frm.mbap.pid = MB_TCP_MBAP_PID;
-    frm.mbap.did = hinst->saddr;
-    frm.pdu.wr_req.fc = func;
-    frm.pdu.wr_req.addr = addr;
-    frm.pdu.wr_req.nb = nb;
-    frm.pdu.wr_req.dlen = dlen;
-    frm.pdu.wr_req.pdata = (uint8_t *)pdata;
-    
-    int flen = modbus_tcp_frm_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen)
     {
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0)
     {
         return(0);
     }
     
     int pdu_len = modbus_tcp_frm_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
-    if (pdu_len < 0)
+    if (pdu_len <= 0)
     {
         return(0);
     }
@@ -306,6 +353,45 @@ static int modbus_write_req_tcp(mb_inst_t *hinst, uint8_t func, uint16_t addr, i
 
 
 
+/**
+ * @brief  发送已封装在 hinst->buf 中的写多个请求并处理响应
+ *
+ * @return int  同 modbus_write_req()
+ */
+static int modbus_write_xfer(mb_inst_t *hinst, int flen)
+{
+    switch (hinst->prototype)
+    {
+        #ifdef MB_USING_RTU_PROTOCOL
+        case MB_PROT_RTU :
+            return(modbus_write_xfer_rtu(hinst, flen));
+        #endif
+        #ifdef MB_USING_TCP_PROTOCOL
+        case MB_PROT_TCP :
+            return(modbus_write_xfer_tcp(hinst, flen));
+        #endif
+        default:
+            break;
+    }
+
+    return(0);
+}
+
+/**
+ * @brief  在 PDU 位置写入写多个请求的头部（功能码、地址、数量、字节数）
+ *
+ * @return uint8_t*  数据区位置，调用者直接在此写入数据
+ */
+static uint8_t *modbus_write_req_head(uint8_t *pdu, uint8_t func, uint16_t addr, int nb, int dlen)
+{
+    uint8_t *p = pdu;
+    p += modbus_cvt_u8_put(p, func);
+    p += modbus_cvt_u16_put(p, addr);
+    p += modbus_cvt_u16_put(p, nb);
+    p += modbus_cvt_u8_put(p, dlen);
+    return(p);
+}
+
 /**
  * @brief  统一写多个操作接口（支持 RTU 和 TCP）
  *
@@ -333,21 +419,18 @@ int modbus_write_req(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, cons
     MB_ASSERT(nb > 0);
     MB_ASSERT(dlen > 0);
 
-    switch (hinst->prototype)
+    if (nb > modbus_nb_max(func))//超出单帧上限, 大范围写入使用modbus_write_range()
     {
-        #ifdef MB_USING_RTU_PROTOCOL
-        case MB_PROT_RTU :
-            return(modbus_write_req_rtu(hinst, func, addr, nb, pdata, dlen));
-        #endif
-        #ifdef MB_USING_TCP_PROTOCOL
-        case MB_PROT_TCP :
-            return(modbus_write_req_tcp(hinst, func, addr, nb, pdata, dlen));
-        #endif
-        default:
-            break;
+        return(0);
     }
-    
-    return(0);
+
+    uint8_t *pdu = modbus_frame_pdu(hinst);
+    uint8_t *p = modbus_write_req_head(pdu, func, addr, nb, dlen);
+    memcpy(p, pdata, dlen);
+
+    int rst = modbus_write_xfer(hinst, modbus_frame_seal(hinst, (int)(p - pdu) + dlen));
+    modbus_master_written(hinst, func, addr, nb);
+    return(rst);
 }
 
 /**
@@ -437,10 +520,7 @@ int modbus_read_regs(mb_inst_t *hinst, uint16_t addr, int nb, uint16_t *pregs)
         return(0);
     }
 
-    uint8_t *p = hinst->datas;
-    for (int i=0; i<nb; i++){
-        p += modbus_cvt_u16_get(p, pregs + i);
-    }
+    modbus_cvt_u16_get_block(hinst->datas, pregs, nb);
 
     return(nb);
 }
@@ -482,10 +562,7 @@ int modbus_read_input_regs(mb_inst_t *hinst, uint16_t addr, int nb, uint16_t *pr
         return(0);
     }
 
-    uint8_t *p = hinst->datas;
-    for (int i=0; i<nb; i++){
-        p += modbus_cvt_u16_get(p, pregs + i);
-    }
+    modbus_cvt_u16_get_block(hinst->datas, pregs, nb);
 
     return(nb);
 }
@@ -521,17 +598,17 @@ static int modbus_write_single_rtu(mb_inst_t *hinst, uint8_t func, uint16_t addr
     frm.pdu.wr_single.val = val;
     
     int flen = modbus_rtu_frame_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen){
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0){
         return(0);
     }
     
-    int pdu_len = modbus_rtu_frame_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
+    int pdu_len = modbus_rtu_frame_parse_crc(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP, modbus_rx_crc(hinst));
     if (pdu_len <= 0){
         return(0);
     }
@@ -564,20 +641,20 @@ static int modbus_write_single_tcp(mb_inst_t *hinst, uint8_t func, uint16_t addr
     frm.pdu.wr_single.val = val;
     
     int flen = modbus_tcp_frm_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen)
     {
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0)
     {
         return(0);
     }
     
     int pdu_len = modbus_tcp_frm_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
-    if (pdu_len < 0)
+    if (pdu_len <= 0)
     {
         return(0);
     }
@@ -628,21 +705,25 @@ static int modbus_write_single_tcp(mb_inst_t *hinst, uint8_t func, uint16_t addr
  */
 static int modbus_write_single(mb_inst_t *hinst, uint8_t func, uint16_t addr, uint16_t val)
 {
+    int rst = 0;
     switch (hinst->prototype)
     {
         #ifdef MB_USING_RTU_PROTOCOL
         case MB_PROT_RTU :
-            return(modbus_write_single_rtu(hinst, func, addr, val));
+            rst = modbus_write_single_rtu(hinst, func, addr, val);
+            break;
         #endif
         #ifdef MB_USING_TCP_PROTOCOL
         case MB_PROT_TCP :
-            return(modbus_write_single_tcp(hinst, func, addr, val));
+            rst = modbus_write_single_tcp(hinst, func, addr, val);
+            break;
         #endif
         default:
             break;
     }
-    
-    return(0);
+
+    modbus_master_written(hinst, func, addr, 1);
+    return(rst);
 }
 
 //写单个线圈, 功能码-0x05, 成功返回1, 异常应答返回负值错误码, 其它错误返回0
@@ -680,13 +761,19 @@ int modbus_write_regs(mb_inst_t *hinst, uint16_t addr, int nb, const uint16_t *p
     MB_ASSERT(pregs != NULL);
     MB_ASSERT(nb > 0);
     
-    uint8_t *p = hinst->datas;
-    for (int i=0; i<nb; i++)
+    if (nb > MODBUS_WRITE_REG_MAX)
     {
-        p += modbus_cvt_u16_put(p, pregs[i]);
+        return(0);
     }
-    int dlen = nb * 2;
-    return(modbus_write_req(hinst, MODBUS_FC_WRITE_MULTIPLE_REGISTERS, addr, nb, hinst->datas, dlen));
+
+    //寄存器直接按大端序编码到发送缓冲区, 不经过hinst->datas
+    uint8_t *pdu = modbus_frame_pdu(hinst);
+    uint8_t *p = modbus_write_req_head(pdu, MODBUS_FC_WRITE_MULTIPLE_REGISTERS, addr, nb, nb * 2);
+    p += modbus_cvt_u16_put_block(p, pregs, nb);
+
+    int rst = modbus_write_xfer(hinst, modbus_frame_seal(hinst, (int)(p - pdu)));
+    modbus_master_written(hinst, MODBUS_FC_WRITE_MULTIPLE_REGISTERS, addr, nb);
+    return(rst);
 }
 
 #ifdef MB_USING_RTU_PROTOCOL
@@ -700,19 +787,19 @@ static int modbus_mask_write_rtu(mb_inst_t *hinst, uint16_t addr, uint16_t val_a
     frm.pdu.mask_wr.val_or = val_or;
     
     int flen = modbus_rtu_frame_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen)
     {
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0)
     {
         return(0);
     }
     
-    int pdu_len = modbus_rtu_frame_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
+    int pdu_len = modbus_rtu_frame_parse_crc(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP, modbus_rx_crc(hinst));
     if (pdu_len <= 0)
     {
         return(0);
@@ -748,20 +835,20 @@ static int modbus_mask_write_tcp(mb_inst_t *hinst, uint16_t addr, uint16_t val_a
     frm.pdu.mask_wr.val_or = val_or;
     
     int flen = modbus_tcp_frm_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen)
     {
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0)
     {
         return(0);
     }
     
     int pdu_len = modbus_tcp_frm_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
-    if (pdu_len < 0)
+    if (pdu_len <= 0)
     {
         return(0);
     }
@@ -794,31 +881,31 @@ int modbus_mask_write_reg(mb_inst_t *hinst, uint16_t addr, uint16_t mask_and, ui
 {
     MB_ASSERT(hinst != NULL);
 
+    int rst = 0;
     switch (hinst->prototype)
     {
     #ifdef MB_USING_RTU_PROTOCOL
     case MB_PROT_RTU :
-        return(modbus_mask_write_rtu(hinst, addr, mask_and, mask_or));
+        rst = modbus_mask_write_rtu(hinst, addr, mask_and, mask_or);
+        break;
     #endif
     #ifdef MB_USING_TCP_PROTOCOL
     case MB_PROT_TCP :
-        return(modbus_mask_write_tcp(hinst, addr, mask_and, mask_or));
+        rst = modbus_mask_write_tcp(hinst, addr, mask_and, mask_or);
+        break;
     #endif
     default:
         break;
     }
-    
-    return(0);
+
+    modbus_master_written(hinst, MODBUS_FC_MASK_WRITE_REGISTER, addr, 1);
+    return(rst);
 }
 
 #ifdef MB_USING_RTU_PROTOCOL
 static int modbus_write_and_read_regs_rtu(mb_inst_t *hinst, uint16_t wr_addr, int wr_nb, const uint16_t *p_wr_regs,uint16_t rd_addr, int rd_nb, uint16_t *p_rd_regs)
 {
-    uint8_t *p = hinst->datas;
-    for (int i=0; i<wr_nb; i++)
-    {
-        p += modbus_cvt_u16_put(p, p_wr_regs[i]);
-    }
+    modbus_cvt_u16_put_block(hinst->datas, p_wr_regs, wr_nb);
     
     mb_rtu_frm_t frm;
     frm.saddr = hinst->saddr;
@@ -831,19 +918,19 @@ static int modbus_write_and_read_regs_rtu(mb_inst_t *hinst, uint16_t wr_addr, in
     frm.pdu.wr_rd_req.pdata = hinst->datas;
     
     int flen = modbus_rtu_frame_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen)
     {
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0)
     {
         return(0);
     }
     
-    int pdu_len = modbus_rtu_frame_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
+    int pdu_len = modbus_rtu_frame_parse_crc(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP, modbus_rx_crc(hinst));
     if (pdu_len <= 0)
     {
         return(0);
@@ -867,11 +954,7 @@ static int modbus_write_and_read_regs_rtu(mb_inst_t *hinst, uint16_t wr_addr, in
         return(0);
     }
 
-    p = frm.pdu.rd_rsp.pdata;
-    for (int i=0; i<rd_nb; i++)
-    {
-        p += modbus_cvt_u16_get(p, p_rd_regs + i);
-    }
+    modbus_cvt_u16_get_block(frm.pdu.rd_rsp.pdata, p_rd_regs, rd_nb);
 
     return(rd_nb);
 }
@@ -880,11 +963,7 @@ static int modbus_write_and_read_regs_rtu(mb_inst_t *hinst, uint16_t wr_addr, in
 #ifdef MB_USING_TCP_PROTOCOL
 static int modbus_write_and_read_regs_tcp(mb_inst_t *hinst, uint16_t wr_addr, int wr_nb, const uint16_t *p_wr_regs,uint16_t rd_addr, int rd_nb, uint16_t *p_rd_regs)
 {
-    uint8_t *p = hinst->datas;
-    for (int i=0; i<wr_nb; i++)
-    {
-        p += modbus_cvt_u16_put(p, p_wr_regs[i]);
-    }
+    modbus_cvt_u16_put_block(hinst->datas, p_wr_regs, wr_nb);
     
     mb_tcp_frm_t frm;
     hinst->tsid++;
@@ -900,20 +979,20 @@ static int modbus_write_and_read_regs_tcp(mb_inst_t *hinst, uint16_t wr_addr, in
     frm.pdu.wr_rd_req.pdata = hinst->datas;
     
     int flen = modbus_tcp_frm_make(hinst->buf, (void *)&frm, MB_PDU_TYPE_REQ);
-    int slen = modbus_send(hinst, hinst->buf, flen);
+    int slen = modbus_master_send(hinst, flen);
     if (slen != flen)
     {
         return(0);
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP);
     if (rlen <= 0)
     {
         return(0);
     }
     
     int pdu_len = modbus_tcp_frm_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
-    if (pdu_len < 0)
+    if (pdu_len <= 0)
     {
         return(0);
     }
@@ -943,11 +1022,7 @@ static int modbus_write_and_read_regs_tcp(mb_inst_t *hinst, uint16_t wr_addr, in
         return(0);
     }
 
-    p = frm.pdu.rd_rsp.pdata;
-    for (int i=0; i<rd_nb; i++)
-    {
-        p += modbus_cvt_u16_get(p, p_rd_regs + i);
-    }
+    modbus_cvt_u16_get_block(frm.pdu.rd_rsp.pdata, p_rd_regs, rd_nb);
 
     return(rd_nb);
 
@@ -963,21 +1038,334 @@ int mb_write_and_read_regs(mb_inst_t *hinst, uint16_t wr_addr, int wr_nb, const
     MB_ASSERT(wr_nb > 0);
     MB_ASSERT(rd_nb > 0);
 
+    if ((wr_nb > MODBUS_WR_WRITE_REG_MAX) || (rd_nb > MODBUS_WR_READ_REG_MAX))//超出单帧上限, 不越界写缓冲区
+    {
+        return(0);
+    }
+
+    int rst = 0;
     switch (hinst->prototype)
     {
     #ifdef MB_USING_RTU_PROTOCOL
     case MB_PROT_RTU :
-        return(modbus_write_and_read_regs_rtu(hinst, wr_addr, wr_nb, p_wr_regs, rd_addr, rd_nb, p_rd_regs));
+        rst = modbus_write_and_read_regs_rtu(hinst, wr_addr, wr_nb, p_wr_regs, rd_addr, rd_nb, p_rd_regs);
+        break;
     #endif
     #ifdef MB_USING_TCP_PROTOCOL
     case MB_PROT_TCP :
-        return(modbus_write_and_read_regs_tcp(hinst, wr_addr, wr_nb, p_wr_regs, rd_addr, rd_nb, p_rd_regs));
+        rst = modbus_write_and_read_regs_tcp(hinst, wr_addr, wr_nb, p_wr_regs, rd_addr, rd_nb, p_rd_regs);
+        break;
     #endif
     default:
         break;
     }
-    
-    return(0);
+
+    modbus_master_written(hinst, MODBUS_FC_WRITE_AND_READ_REGISTERS, wr_addr, wr_nb);
+    return(rst);
 }
                                      
+
+/**
+ * @brief  数据区中第 off 个位或寄存器的地址
+ *
+ * 位按字节偏移（分块上限均为 8 的整数倍），寄存器按 uint16_t 偏移。
+ */
+static void *modbus_range_ptr(uint8_t func, const void *pdata, int off)
+{
+    if ((func == MODBUS_FC_READ_COILS) || (func == MODBUS_FC_READ_DISCRETE_INPUTS) || (func == MODBUS_FC_WRITE_MULTIPLE_COILS))
+    {
+        return((uint8_t *)pdata + off / 8);
+    }
+    return((uint16_t *)pdata + off);
+}
+
+#if (defined(MB_USING_TCP_PIPELINE) && defined(MB_USING_TCP_PROTOCOL))
+
+typedef struct{
+    mb_inst_t *hinst;   //所属实例
+    uint8_t func;       //功能码
+    uint16_t addr;      //本块起始地址
+    int nb;             //本块数量
+    void *pdata;        //本块数据
+    int *prst;          //共享结果, 任一块失败时记录该块结果
+}mb_range_chunk_t;//流水线分块上下文
+
+/**
+ * @brief  流水线分块完成回调
+ */
+static void modbus_range_pipe_cb(void *arg, int rst, const uint8_t *pdata, int dlen)
+{
+    mb_range_chunk_t *chk = (mb_range_chunk_t *)arg;
+    int ok = 0;
+
+    switch(chk->func)
+    {
+    case MODBUS_FC_READ_COILS :
+    case MODBUS_FC_READ_DISCRETE_INPUTS :
+        if ((rst > 0) && (dlen == (chk->nb + 7) / 8))
+        {
+            memcpy(chk->pdata, pdata, dlen);
+            ok = 1;
+        }
+        break;
+    case MODBUS_FC_READ_HOLDING_REGISTERS :
+    case MODBUS_FC_READ_INPUT_REGISTERS :
+        if ((rst > 0) && (dlen == chk->nb * 2))
+        {
+            modbus_cvt_u16_get_block(pdata, (uint16_t *)chk->pdata, chk->nb);
+            ok = 1;
+        }
+        break;
+    default:
+        ok = (rst == chk->nb);
+        if (rst >= 0)//已发出的写块(含超时, 从机可能已执行), 异常应答说明未写入
+        {
+            modbus_master_written(chk->hinst, chk->func, chk->addr, chk->nb);
+        }
+        break;
+    }
+
+    if (( ! ok) && (*(chk->prst) > 0))
+    {
+        *(chk->prst) = (rst < 0) ? rst : 0;
+    }
+}
+
+/**
+ * @brief  以流水线方式执行分块请求
+ *
+ * 全部分块依次提交（窗口满时先接收响应），最后等待全部完成。
+ *
+ * @return int  全部成功返回 nb，否则返回失败块的结果（0 或负数异常码）
+ */
+static int modbus_range_pipe(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, void *pdata, int cap)
+{
+    int cnt = (nb + cap - 1) / cap;
+    mb_pipe_t *pipe = modbus_pipe_create(hinst, MB_RANGE_PIPE_WIN);
+    mb_range_chunk_t *chk = malloc(cnt * sizeof(mb_range_chunk_t));
+    if ((pipe == NULL) || (chk == NULL))
+    {
+        modbus_pipe_destroy(pipe);
+        free(chk);
+        return(0);
+    }
+
+    int rst = nb;
+    for (int i=0; (i<cnt) && (rst > 0); i++)
+    {
+        int off = i * cap;
+        int n = ((nb - off) > cap) ? cap : (nb - off);
+        chk[i].hinst = hinst;
+        chk[i].func = func;
+        chk[i].addr = addr + off;
+        chk[i].nb = n;
+        chk[i].pdata = modbus_range_ptr(func, pdata, off);
+        chk[i].prst = &rst;
+
+        int tid;
+        if (func == MODBUS_FC_WRITE_MULTIPLE_REGISTERS)
+        {
+            int dlen = modbus_cvt_u16_put_block(hinst->datas, (const uint16_t *)chk[i].pdata, n);
+            tid = modbus_pipe_write_req(pipe, func, addr + off, n, hinst->datas, dlen, modbus_range_pipe_cb, &chk[i]);
+        }
+        else if (func == MODBUS_FC_WRITE_MULTIPLE_COILS)
+        {
+            tid = modbus_pipe_write_req(pipe, func, addr + off, n, (const uint8_t *)chk[i].pdata, (n + 7) / 8, modbus_range_pipe_cb, &chk[i]);
+        }
+        else
+        {
+            tid = modbus_pipe_read_req(pipe, func, addr + off, n, modbus_range_pipe_cb, &chk[i]);
+        }
+        if (tid < 0)
+        {
+            rst = 0;
+        }
+    }
+
+    if (modbus_pipe_wait_all(pipe) < 0)
+    {
+        rst = 0;
+    }
+
+    modbus_pipe_destroy(pipe);
+    free(chk);
+    return(rst);
+}
+#endif
+
+/**
+ * @brief  分块执行大范围请求
+ *
+ * 写入时每个已发出的块各自使读缓存中对应区间失效，未发出的块不影响缓存。
+ *
+ * @return int  全部成功返回 nb，否则返回失败块的结果（0 或负数异常码），参数非法返回 0
+ */
+static int modbus_range_exec(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, void *pdata)
+{
+    int cap = modbus_nb_max(func);
+    if ((cap == 0) || (nb <= 0) || (((uint32_t)addr + nb) > 0x10000))
+    {
+        return(0);
+    }
+
+    #if (defined(MB_USING_TCP_PIPELINE) && defined(MB_USING_TCP_PROTOCOL))
+    // 1. TCP协议下多块请求使用流水线, 多个块同时在途, 写块在完成回调中使缓存失效
+    if ((hinst->prototype == MB_PROT_TCP) && (nb > cap) && (MB_RANGE_PIPE_WIN > 1))
+    {
+        return(modbus_range_pipe(hinst, func, addr, nb, pdata, cap));
+    }
+    #endif
+
+    // 2. 逐块同步执行, 写块由 modbus_write_bits/modbus_write_regs 各自使缓存失效
+    for (int off=0; off<nb; off+=cap)
+    {
+        int n = ((nb - off) > cap) ? cap : (nb - off);
+        void *p = modbus_range_ptr(func, pdata, off);
+        int rst;
+        switch(func)
+        {
+        case MODBUS_FC_READ_COILS :
+            rst = modbus_read_bits(hinst, addr + off, n, (uint8_t *)p);
+            break;
+        case MODBUS_FC_READ_DISCRETE_INPUTS :
+            rst = modbus_read_input_bits(hinst, addr + off, n, (uint8_t *)p);
+            break;
+        case MODBUS_FC_READ_HOLDING_REGISTERS :
+            rst = modbus_read_regs(hinst, addr + off, n, (uint16_t *)p);
+            break;
+        case MODBUS_FC_READ_INPUT_REGISTERS :
+            rst = modbus_read_input_regs(hinst, addr + off, n, (uint16_t *)p);
+            break;
+        case MODBUS_FC_WRITE_MULTIPLE_COILS :
+            rst = modbus_write_bits(hinst, addr + off, n, (const uint8_t *)p);
+            break;
+        default:
+            rst = modbus_write_regs(hinst, addr + off, n, (const uint16_t *)p);
+            break;
+        }
+        if (rst != n)
+        {
+            return((rst < 0) ? rst : 0);
+        }
+    }
+
+    return(nb);
+}
+
+
+/**
+ * @brief  大范围读取（功能码 0x01~0x04）
+ *
+ * 数量不受单帧上限限制，自动按 MODBUS_READ_BITS_MAX / MODBUS_READ_REG_MAX
+ * 拆分为最大合法块依次读取；TCP 协议下多个块以流水线方式同时在途
+ * （窗口 MB_RANGE_PIPE_WIN），批量读取配方表等数据时调用者无需自行分块。
+ *
+ * @param[in,out] hinst  Modbus 实例指针
+ * @param[in]     func   功能码
+ * @param[in]     addr   起始地址
+ * @param[in]     nb     数量（addr + nb 不超过 65536）
+ * @param[out]    pdata  输出数据，位为低位在前的位表（uint8_t[]），寄存器为主机序（uint16_t[]）
+ *
+ * @return int
+ *   - >0 : 成功，返回 nb
+ *   -  0 : 某块通信失败，或功能码、范围非法
+ *   - <0 : 某块异常响应（-异常码）
+ *
+ * @note
+ *   - 失败时已完成块的数据已写入 pdata，其余部分内容不确定
+ *   - 流水线临时占用实例的收发缓冲区，调用期间不要在同一实例上发起其它请求
+ */
+int modbus_read_range(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, void *pdata)
+{
+    MB_ASSERT(hinst != NULL);
+    MB_ASSERT(pdata != NULL);
+
+    if ((func != MODBUS_FC_READ_COILS) && (func != MODBUS_FC_READ_DISCRETE_INPUTS)
+        && (func != MODBUS_FC_READ_HOLDING_REGISTERS) && (func != MODBUS_FC_READ_INPUT_REGISTERS))
+    {
+        return(0);
+    }
+
+    return(modbus_range_exec(hinst, func, addr, nb, pdata));
+}
+
+
+/**
+ * @brief  大范围写入（功能码 0x0F / 0x10）
+ *
+ * 按 MODBUS_WRITE_BITS_MAX / MODBUS_WRITE_REG_MAX 拆分，其余同 modbus_read_range()。
+ *
+ * @param[in,out] hinst  Modbus 实例指针
+ * @param[in]     func   功能码
+ * @param[in]     addr   起始地址
+ * @param[in]     nb     数量（addr + nb 不超过 65536）
+ * @param[in]     pdata  写入数据，位为低位在前的位表（uint8_t[]），寄存器为主机序（uint16_t[]）
+ *
+ * @return int  同 modbus_read_range()
+ *
+ * @note
+ *   - 写入不是原子的，失败时已完成的块已写入从机
+ */
+int modbus_write_range(mb_inst_t *hinst, uint8_t func, uint16_t addr, int nb, const void *pdata)
+{
+    MB_ASSERT(hinst != NULL);
+    MB_ASSERT(pdata != NULL);
+
+    if ((func != MODBUS_FC_WRITE_MULTIPLE_COILS) && (func != MODBUS_FC_WRITE_MULTIPLE_REGISTERS))
+    {
+        return(0);
+    }
+
+    return(modbus_range_exec(hinst, func, addr, nb, (void *)pdata));
+}
+
+
+
+/**
+ * @brief  按功能码执行一次主机请求
+ *
+ * 请求队列、轮询调度等按表驱动的模块统一经此调用同步接口。
+ *
+ * @param[in,out] hinst  Modbus 实例指针
+ * @param[in]     saddr  从机地址
+ * @param[in]     fc     功能码（0x01~0x06、0x0F、0x10）
+ * @param[in]     addr   起始地址
+ * @param[in]     nb     数量（写单个时忽略）
+ * @param[in,out] pdata  数据，读为输出（位表或 uint16_t[]），
+ *                       写单个为值指针（uint8_t* 或 uint16_t*），写多个为输入
+ *
+ * @return int  同对应的同步接口，功能码不支持返回 -MODBUS_EC_ILLEGAL_FUNCTION
+ */
+int modbus_master_call(mb_inst_t *hinst, uint8_t saddr, uint8_t fc, uint16_t addr, int nb, void *pdata)
+{
+    MB_ASSERT(hinst != NULL);
+    MB_ASSERT(pdata != NULL);
+
+    modbus_set_slave_addr(hinst, saddr);
+
+    switch(fc)
+    {
+    case MODBUS_FC_READ_COILS :
+        return(modbus_read_bits(hinst, addr, nb, (uint8_t *)pdata));
+    case MODBUS_FC_READ_DISCRETE_INPUTS :
+        return(modbus_read_input_bits(hinst, addr, nb, (uint8_t *)pdata));
+    case MODBUS_FC_READ_HOLDING_REGISTERS :
+        return(modbus_read_regs(hinst, addr, nb, (uint16_t *)pdata));
+    case MODBUS_FC_READ_INPUT_REGISTERS :
+        return(modbus_read_input_regs(hinst, addr, nb, (uint16_t *)pdata));
+    case MODBUS_FC_WRITE_SINGLE_COIL :
+        return(modbus_write_bit(hinst, addr, *(uint8_t *)pdata));
+    case MODBUS_FC_WRITE_SINGLE_REGISTER :
+        return(modbus_write_reg(hinst, addr, *(uint16_t *)pdata));
+    case MODBUS_FC_WRITE_MULTIPLE_COILS :
+        return(modbus_write_bits(hinst, addr, nb, (const uint8_t *)pdata));
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
+        return(modbus_write_regs(hinst, addr, nb, (const uint16_t *)pdata));
+    default:
+        break;
+    }
+
+    return(-MODBUS_EC_ILLEGAL_FUNCTION);
+}
+
 #endif
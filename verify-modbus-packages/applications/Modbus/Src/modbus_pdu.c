@@ -8,553 +8,420 @@
  * 2025-11-12     18452       the first version
  */
 #include "bsp_sys.h"
+#include <stddef.h>
 
 
+/*
+ * PDU 格式表
+ * 各功能码的 PDU 均为：功能码(1) + nw 个 16 位字段(大端) + [字节计数(1) + 数据(字节计数)]，
+ * 只有字段个数和字段在 mb_pdu_t 各成员结构体中的偏移不同，统一由通用编解码函数处理。
+ */
+#define MB_PDU_FMT_W2(type, a, b)           2, {offsetof(type, a), offsetof(type, b)}
+#define MB_PDU_FMT_W3(type, a, b, c)        3, {offsetof(type, a), offsetof(type, b), offsetof(type, c)}
+#define MB_PDU_FMT_W4(type, a, b, c, d)     4, {offsetof(type, a), offsetof(type, b), offsetof(type, c), offsetof(type, d)}
+#define MB_PDU_FMT_DATA(type)               offsetof(type, dlen), offsetof(type, pdata)
+
+static const mb_pdu_fmt_t mb_pdu_fmt_rd_req     = {5,  MB_PDU_FMT_W2(mb_pdu_rd_req_t, addr, nb), 0, 0};
+static const mb_pdu_fmt_t mb_pdu_fmt_rd_rsp     = {2,  0, {0}, MB_PDU_FMT_DATA(mb_pdu_rd_rsp_t)};
+static const mb_pdu_fmt_t mb_pdu_fmt_wr_single  = {5,  MB_PDU_FMT_W2(mb_pdu_wr_single_t, addr, val), 0, 0};
+static const mb_pdu_fmt_t mb_pdu_fmt_wr_req     = {6,  MB_PDU_FMT_W2(mb_pdu_wr_req_t, addr, nb), MB_PDU_FMT_DATA(mb_pdu_wr_req_t)};
+static const mb_pdu_fmt_t mb_pdu_fmt_wr_rsp     = {5,  MB_PDU_FMT_W2(mb_pdu_wr_rsp_t, addr, nb), 0, 0};
+static const mb_pdu_fmt_t mb_pdu_fmt_mask_wr    = {7,  MB_PDU_FMT_W3(mb_pdu_mask_wr_t, addr, val_and, val_or), 0, 0};
+static const mb_pdu_fmt_t mb_pdu_fmt_wr_rd_req  = {10, MB_PDU_FMT_W4(mb_pdu_wr_rd_req_t, rd_addr, rd_nb, wr_addr, wr_nb), MB_PDU_FMT_DATA(mb_pdu_wr_rd_req_t)};
+
+/*
+ * 功能码描述表, 以功能码为下标 O(1) 查找, 未列出的功能码 req 为 NULL(不支持)
+ * 增加功能码(如 0x07/0x11/0x2B)只需在此添加一项, 必要时增加格式并扩大 MB_PDU_FC_TAB_SIZE
+ * 有读数量时请求的前两个16位字段为读地址和读数量, 有写数量时最后两个16位字段为写地址和写数量
+ */
+static const mb_pdu_desc_t mb_pdu_desc_tab[MB_PDU_FC_TAB_SIZE] = {
+    [MODBUS_FC_READ_COILS]               = {&mb_pdu_fmt_rd_req,    &mb_pdu_fmt_rd_rsp,    1, MODBUS_READ_BITS_MAX,   0},
+    [MODBUS_FC_READ_DISCRETE_INPUTS]     = {&mb_pdu_fmt_rd_req,    &mb_pdu_fmt_rd_rsp,    1, MODBUS_READ_BITS_MAX,   0},
+    [MODBUS_FC_READ_HOLDING_REGISTERS]   = {&mb_pdu_fmt_rd_req,    &mb_pdu_fmt_rd_rsp,    0, MODBUS_READ_REG_MAX,    0},
+    [MODBUS_FC_READ_INPUT_REGISTERS]     = {&mb_pdu_fmt_rd_req,    &mb_pdu_fmt_rd_rsp,    0, MODBUS_READ_REG_MAX,    0},
+    [MODBUS_FC_WRITE_SINGLE_COIL]        = {&mb_pdu_fmt_wr_single, &mb_pdu_fmt_wr_single, 1, 0,                      0},
+    [MODBUS_FC_WRITE_SINGLE_REGISTER]    = {&mb_pdu_fmt_wr_single, &mb_pdu_fmt_wr_single, 0, 0,                      0},
+    [MODBUS_FC_WRITE_MULTIPLE_COILS]     = {&mb_pdu_fmt_wr_req,    &mb_pdu_fmt_wr_rsp,    1, 0,                      MODBUS_WRITE_BITS_MAX},
+    [MODBUS_FC_WRITE_MULTIPLE_REGISTERS] = {&mb_pdu_fmt_wr_req,    &mb_pdu_fmt_wr_rsp,    0, 0,                      MODBUS_WRITE_REG_MAX},
+    [MODBUS_FC_MASK_WRITE_REGISTER]      = {&mb_pdu_fmt_mask_wr,   &mb_pdu_fmt_mask_wr,   0, 0,                      0},
+    [MODBUS_FC_WRITE_AND_READ_REGISTERS] = {&mb_pdu_fmt_wr_rd_req, &mb_pdu_fmt_rd_rsp,    0, MODBUS_WR_READ_REG_MAX, MODBUS_WR_WRITE_REG_MAX},
+};
+
 
 /**
- * @brief  生成 Modbus PDU 异常响应帧
- *
- * 将异常结构体（功能码 + 异常码）转换为 PDU 字节流。
- * 异常响应结构：功能码 (原码 | 0x80) + 异常码 (1字节)。
- * 返回生成的 PDU 长度（始终为 2）。
- *
- * @param[out] buf  目标缓冲区指针（必须至少 2 字节）
- * @param[in]  exc  指向异常结构体的指针（包含 fc 和 ec）
+ * @brief  查找功能码描述
  *
- * @return int  生成的 PDU 长度（2），表示成功
+ * @param[in] fc  功能码（不含异常位）
  *
- * @note
- *   - 依赖 modbus_cvt_u8_put() 写入字节
- *   - 用于从站响应异常情况，如非法功能码、地址错误
- *   - 上层需确保 fc 已设置异常位 (0x80)
+ * @return const mb_pdu_desc_t*  支持的功能码返回描述，否则返回 NULL
  */
-static int modbus_pdu_except_make(uint8_t *buf, const mb_pdu_except_t *exc)
+const mb_pdu_desc_t *modbus_pdu_desc(uint8_t fc)
 {
-    uint8_t *p = buf;
-
-    p += modbus_cvt_u8_put(p, exc->fc);
-    p += modbus_cvt_u8_put(p, exc->ec);
+    if ((fc >= MB_PDU_FC_TAB_SIZE) || (mb_pdu_desc_tab[fc].req == NULL))
+    {
+        return(NULL);
+    }
 
-    return((int)(p - buf));
+    return(&(mb_pdu_desc_tab[fc]));
 }
 
 
 /**
- * @brief  解析 Modbus PDU 异常响应帧
+ * @brief  计算功能码 nb 个数量对应的数据字节数
  *
- * 将异常 PDU 字节流转换为 mb_pdu_except_t 结构体。
- * 异常响应结构：异常功能码 (原码 | 0x80) + 异常码 (1字节)。
- *
- * @param[in]  buf  源缓冲区指针（包含至少 2 字节）
- * @param[in]  len  缓冲区长度（>= 2）
- * @param[out] exc  指向异常结构体的指针（填充 fc 和 ec）
- *
- * @return int
- *   - 2 : 解析成功
- *   - 0 : 帧太短（len < 2）
+ * @param[in] fc  功能码
+ * @param[in] nb  数量（位或寄存器）
  *
- * @note
- *   - 仅解析格式，不验证功能码是否合法（上层通过 MODBUS_FC_EXCEPT_CHK 检查）
- *   - 常用于主站处理从站异常响应
+ * @return int  位为 (nb+7)/8，寄存器为 nb×2，功能码不支持返回 0
  */
-static int modbus_pdu_except_parse(const uint8_t *buf, int len, mb_pdu_except_t *exc)
+int modbus_pdu_data_len(uint8_t fc, int nb)
 {
-    if (len < 2)
+    const mb_pdu_desc_t *desc = modbus_pdu_desc(fc);
+    if (desc == NULL)
     {
         return(0);
     }
 
-    uint8_t *p = (uint8_t *)buf;
+    return(desc->bits ? ((nb + 7) / 8) : (nb * 2));
+}
 
-    p += modbus_cvt_u8_get(p, &(exc->fc));
-    p += modbus_cvt_u8_get(p, &(exc->ec));
 
-    return((int)(p - buf));
+/**
+ * @brief  检查数量和地址范围
+ *
+ * @return int  0-合法, 数量为 0 或超过上限返回非法数据值, 地址+数量超出 0x10000 返回非法数据地址
+ */
+static int modbus_pdu_range_check(uint16_t addr, uint16_t nb, uint16_t nb_max)
+{
+    if ((nb == 0) || (nb > nb_max))
+    {
+        return(MODBUS_EC_ILLEGAL_DATA_VALUE);
+    }
+    if (((uint32_t)addr + nb) > 0x10000)
+    {
+        return(MODBUS_EC_ILLEGAL_DATA_ADDRESS);
+    }
+    return(0);
 }
 
 
 /**
- * @brief  生成 Modbus PDU 读请求帧
+ * @brief  从站请求合法性检查
  *
- * 将读请求结构体转换为 5 字节 PDU（大端序）：
- *   - 结构：功能码(1) + 起始地址(2) + 数量(2)
- * 支持功能码：0x01, 0x02, 0x03, 0x04
+ * 在调用任何寄存器回调之前，按功能码描述表检查已解析的请求：
+ *   1. 功能码不支持                          -> 0x01 非法功能码
+ *   2. 读/写数量为 0 或超过协议上限          -> 0x03 非法数据值
+ *   3. 字节计数与写数量不一致                -> 0x03 非法数据值
+ *   4. 写单个线圈的值不是 0xFF00 或 0x0000   -> 0x03 非法数据值
+ *   5. 起始地址 + 数量超出 0x10000           -> 0x02 非法数据地址
  *
- * @param[out] buf     目标缓冲区指针（至少 5 字节）
- * @param[in]  rd_req  指向读请求结构体的指针
- *                     - fc:   功能码（0x01~0x04）
- *                     - addr: 起始地址（0~65535）
- *                     - nb:   数量（1~最大值）
+ * @param[in] pdu  已由 modbus_pdu_parse() 解析的请求
  *
- * @return int  生成的 PDU 长度（5），表示成功
+ * @return int  0-合法, >0-应答的异常码
  *
  * @note
- *   - 常用于主站发起读操作
+ *   - 字节计数不超出接收长度已在解析时保证，此处保证数量、字节计数和地址三者一致，
+ *     从站按数量处理时不会越过请求数据或响应缓冲区
  */
-static int modbus_pdu_rd_req_make(uint8_t *buf, const mb_pdu_rd_req_t *rd_req)
+int modbus_pdu_check(const mb_pdu_t *pdu)
 {
-    // 工作指针
-    uint8_t *p = buf;
+    const mb_pdu_desc_t *desc = modbus_pdu_desc(pdu->fc);
+    if (desc == NULL)
+    {
+        return(MODBUS_EC_ILLEGAL_FUNCTION);
+    }
 
-    // 写入功能码（1字节）
-    p += modbus_cvt_u8_put(p, rd_req->fc);
-    // 写入起始地址（2字节，大端）
-    p += modbus_cvt_u16_put(p, rd_req->addr);
-    // 写入数量（2字节，大端）
-    p += modbus_cvt_u16_put(p, rd_req->nb);
+    const mb_pdu_fmt_t *fmt = desc->req;
+    const uint8_t *s = (const uint8_t *)pdu;
+    int ec = 0;
 
-    return((int)(p - buf));
-}
+    // 1. 读部分: 前两个字段为读地址和读数量
+    if (desc->rd_max != 0)
+    {
+        uint16_t addr = *(const uint16_t *)(s + fmt->w_off[0]);
+        uint16_t nb = *(const uint16_t *)(s + fmt->w_off[1]);
+        ec = modbus_pdu_range_check(addr, nb, desc->rd_max);
+        if (ec != 0)
+        {
+            return(ec);
+        }
+    }
 
+    // 2. 写部分: 最后两个字段为写地址和写数量, 字节计数须与写数量一致
+    if (desc->wr_max != 0)
+    {
+        uint16_t addr = *(const uint16_t *)(s + fmt->w_off[fmt->nw - 2]);
+        uint16_t nb = *(const uint16_t *)(s + fmt->w_off[fmt->nw - 1]);
+        if ((nb != 0) && (nb <= desc->wr_max) && (s[fmt->dlen_off] != modbus_pdu_data_len(pdu->fc, nb)))
+        {
+            return(MODBUS_EC_ILLEGAL_DATA_VALUE);
+        }
+        ec = modbus_pdu_range_check(addr, nb, desc->wr_max);
+        if (ec != 0)
+        {
+            return(ec);
+        }
+    }
+
+    // 3. 写单个线圈只允许 ON(0xFF00) 和 OFF(0x0000)
+    if ((pdu->fc == MODBUS_FC_WRITE_SINGLE_COIL) && (pdu->wr_single.val != 0xFF00) && (pdu->wr_single.val != 0x0000))
+    {
+        return(MODBUS_EC_ILLEGAL_DATA_VALUE);
+    }
+
+    return(0);
+}
 
 
 /**
- * @brief  解析 Modbus PDU 读请求帧
- *
- * 将 5 字节读请求 PDU（大端序）转换为 mb_pdu_rd_req_t 结构体：
- *   - 结构：功能码(1) + 起始地址(2) + 数量(2)
- * 支持功能码：0x01, 0x02, 0x03, 0x04
- *
- * @param[in]  buf     源缓冲区指针（包含至少 5 字节）
- * @param[in]  len     缓冲区长度（>= 5）
- * @param[out] rd_req  指向读请求结构体的指针（填充 fc, addr, nb）
- *
- * @return int
- *   - 5 : 解析成功
- *   - 0 : 帧太短（len < 5）
+ * @brief  取功能码在指定方向上的 PDU 格式
  *
- * @note
- *   - 常用于从站处理主站读请求
+ * @return const mb_pdu_fmt_t*  功能码不支持返回 NULL
  */
-static int modbus_pdu_rd_req_parse(const uint8_t *buf, int len, mb_pdu_rd_req_t *rd_req)
+static const mb_pdu_fmt_t *modbus_pdu_fmt(uint8_t fc, mb_pdu_type_t type)
 {
-    if (len < 5)
+    const mb_pdu_desc_t *desc = modbus_pdu_desc(fc);
+    if (desc == NULL)
     {
-        return(0);
+        return(NULL);
     }
 
-    uint8_t *p = (uint8_t *)buf;
-
-    p += modbus_cvt_u8_get(p, &(rd_req->fc));
-    p += modbus_cvt_u16_get(p, &(rd_req->addr));
-    p += modbus_cvt_u16_get(p, &(rd_req->nb));
-
-    return((int)(p - buf));
+    return((type == MB_PDU_TYPE_REQ) ? desc->req : desc->rsp);
 }
 
 
 /**
- * @brief  生成 Modbus PDU 读响应帧
+ * @brief  生成 Modbus PDU 异常响应帧
  *
- * 将读响应结构体转换为变长 PDU（大端序）：
- *   - 结构：功能码(1) + 数据字节数(1) + 数据(dlen)
- * 支持功能码：0x01, 0x02, 0x03, 0x04
+ * 将异常结构体（功能码 + 异常码）转换为 PDU 字节流。
+ * 异常响应结构：功能码 (原码 | 0x80) + 异常码 (1字节)。
+ * 返回生成的 PDU 长度（始终为 2）。
  *
- * @param[out] buf     目标缓冲区指针（至少 2 + dlen 字节）
- * @param[in]  rd_rsp  指向读响应结构体的指针
- *                     - fc:    功能码（0x01~0x04）
- *                     - dlen:  数据字节数（由 nb 计算）
- *                     - pdata: 数据缓冲区指针（不可为 NULL）
+ * @param[out] buf  目标缓冲区指针（必须至少 2 字节）
+ * @param[in]  exc  指向异常结构体的指针（包含 fc 和 ec）
  *
- * @return int  生成的 PDU 总长度（2 + dlen）
+ * @return int  生成的 PDU 长度（2），表示成功
  *
  * @note
- *   - 数据 pdata 必须为大端序（由上层转换）
- *   - 常用于从站响应主站读请求
+ *   - 依赖 modbus_cvt_u8_put() 写入字节
+ *   - 用于从站响应异常情况，如非法功能码、地址错误
+ *   - 上层需确保 fc 已设置异常位 (0x80)
  */
-static int modbus_pdu_rd_rsp_make(uint8_t *buf, const mb_pdu_rd_rsp_t *rd_rsp)
+static int modbus_pdu_except_make(uint8_t *buf, const mb_pdu_except_t *exc)
 {
     uint8_t *p = buf;
 
-    // 写入功能码（1字节）
-    p += modbus_cvt_u8_put(p, rd_rsp->fc);
-    // 写入数据字节数（1字节）
-    p += modbus_cvt_u8_put(p, rd_rsp->dlen);
-    // 复制实际数据
-    memcpy(p, rd_rsp->pdata, rd_rsp->dlen);
-    // 指针前移
-    p += rd_rsp->dlen;
+    p += modbus_cvt_u8_put(p, exc->fc);
+    p += modbus_cvt_u8_put(p, exc->ec);
 
     return((int)(p - buf));
 }
 
 
 /**
- * @brief  解析 Modbus PDU 读响应帧（变长）
+ * @brief  解析 Modbus PDU 异常响应帧
  *
- * 将读响应 PDU 转换为 mb_pdu_rd_rsp_t 结构体（零拷贝）：
- *   - 结构：功能码(1) + 数据字节数(1) + 数据(dlen)
- * 支持功能码：0x01, 0x02, 0x03, 0x04
+ * 将异常 PDU 字节流转换为 mb_pdu_except_t 结构体。
+ * 异常响应结构：异常功能码 (原码 | 0x80) + 异常码 (1字节)。
  *
- * @param[in]  buf     源缓冲区指针（包含完整 PDU）
- * @param[in]  len     缓冲区长度
- * @param[out] rd_rsp  指向读响应结构体的指针
- *                     - fc:    功能码
- *                     - dlen:  数据字节数
- *                     - pdata: 指向 buf 中数据区的指针（零拷贝）
+ * @param[in]  buf  源缓冲区指针（包含至少 2 字节）
+ * @param[in]  len  缓冲区长度（>= 2）
+ * @param[out] exc  指向异常结构体的指针（填充 fc 和 ec）
  *
  * @return int
- *   - (2 + dlen) : 解析成功
- *   - 0          : 帧太短或数据不完整
+ *   - 2 : 解析成功
+ *   - 0 : 帧太短（len < 2）
  *
  * @note
- *   - 采用零拷贝设计：pdata 直接指向 buf，减少内存操作
- *   - pdata 生命周期与 buf 绑定，buf 释放前不可使用 pdata
- *   - 常用于主站解析从站响应
+ *   - 仅解析格式，不验证功能码是否合法（上层通过 MODBUS_FC_EXCEPT_CHK 检查）
+ *   - 常用于主站处理从站异常响应
  */
-static int modbus_pdu_rd_rsp_parse(const uint8_t *buf, int len, mb_pdu_rd_rsp_t *rd_rsp)
-{
-    // 最小：fc(1) + dlen(1) + 数据(至少1)
-    if (len < 3){
-        return(0);
-    }
-    // 工作指针
-    uint8_t *p = (uint8_t *)buf;
-    // 读取功能码
-    p += modbus_cvt_u8_get(p, &(rd_rsp->fc));
-    // 读取数据长度
-    p += modbus_cvt_u8_get(p, &(rd_rsp->dlen));
-    // pdata 指向数据区（零拷贝）
-    rd_rsp->pdata = p;
-    // 跳过数据
-    p += rd_rsp->dlen;
-
-    return((int)(p - buf));
-}
-
-static int modbus_pdu_wr_single_make(uint8_t *buf, const mb_pdu_wr_single_t *wr_single)
-{
-    uint8_t *p = buf;
-
-    p += modbus_cvt_u8_put(p, wr_single->fc);
-    p += modbus_cvt_u16_put(p, wr_single->addr);
-    p += modbus_cvt_u16_put(p, wr_single->val);
-
-    return((int)(p - buf));
-}
-
-static int modbus_pdu_wr_single_parse(const uint8_t *buf, int len, mb_pdu_wr_single_t *wr_single)
+static int modbus_pdu_except_parse(const uint8_t *buf, int len, mb_pdu_except_t *exc)
 {
-    if (len < 5)
+    if (len < 2)
     {
         return(0);
     }
 
     uint8_t *p = (uint8_t *)buf;
 
-    p += modbus_cvt_u8_get(p, &(wr_single->fc));
-    p += modbus_cvt_u16_get(p, &(wr_single->addr));
-    p += modbus_cvt_u16_get(p, &(wr_single->val));
+    p += modbus_cvt_u8_get(p, &(exc->fc));
+    p += modbus_cvt_u8_get(p, &(exc->ec));
 
     return((int)(p - buf));
 }
 
-static int modbus_pdu_wr_req_make(uint8_t *buf, const mb_pdu_wr_req_t *wr_req)
+
+/**
+ * @brief  按格式描述生成 PDU
+ *
+ * 依次写入功能码、各 16 位字段（大端）、字节计数和数据。
+ *
+ * @param[out] buf  目标缓冲区
+ * @param[in]  pdu  PDU 结构体
+ * @param[in]  fmt  PDU 格式
+ *
+ * @return int  生成的 PDU 长度
+ *
+ * @note
+ *   - 数据指针已指向 buf 中的数据位置时（零拷贝编码）不再拷贝
+ */
+static int modbus_pdu_fmt_make(uint8_t *buf, const mb_pdu_t *pdu, const mb_pdu_fmt_t *fmt)
 {
+    const uint8_t *s = (const uint8_t *)pdu;
     uint8_t *p = buf;
 
-    p += modbus_cvt_u8_put(p, wr_req->fc);
-    p += modbus_cvt_u16_put(p, wr_req->addr);
-    p += modbus_cvt_u16_put(p, wr_req->nb);
-    p += modbus_cvt_u8_put(p, wr_req->dlen);
-    memcpy(p, wr_req->pdata, wr_req->dlen);
-    p += wr_req->dlen;
-
-    return((int)(p - buf));
-}
-
-static int modbus_pdu_wr_req_parse(const uint8_t *buf, int len, mb_pdu_wr_req_t *wr_req)
-{
-    if (len < 7)
+    p += modbus_cvt_u8_put(p, pdu->fc);
+    for (int i=0; i<fmt->nw; i++)
     {
-        return(0);
+        p += modbus_cvt_u16_put(p, *(const uint16_t *)(s + fmt->w_off[i]));
     }
 
-    uint8_t *p = (uint8_t *)buf;
-
-    p += modbus_cvt_u8_get(p, &(wr_req->fc));
-    p += modbus_cvt_u16_get(p, &(wr_req->addr));
-    p += modbus_cvt_u16_get(p, &(wr_req->nb));
-    p += modbus_cvt_u8_get(p, &(wr_req->dlen));
-    wr_req->pdata = p;
-    p += wr_req->dlen;
+    if (fmt->dlen_off != 0)
+    {
+        uint8_t dlen = s[fmt->dlen_off];
+        const uint8_t *pdata = *(uint8_t * const *)(s + fmt->pdata_off);
+        p += modbus_cvt_u8_put(p, dlen);
+        if (pdata != p)
+        {
+            memcpy(p, pdata, dlen);
+        }
+        p += dlen;
+    }
 
     return((int)(p - buf));
 }
 
-static int modbus_pdu_wr_rsp_make(uint8_t *buf, const mb_pdu_wr_rsp_t *wr_rsp)
-{
-    uint8_t *p = buf;
-
-    p += modbus_cvt_u8_put(p, wr_rsp->fc);
-    p += modbus_cvt_u16_put(p, wr_rsp->addr);
-    p += modbus_cvt_u16_put(p, wr_rsp->nb);
 
-    return((int)(p - buf));
-}
-
-static int modbus_pdu_wr_rsp_parse(const uint8_t *buf, int len, mb_pdu_wr_rsp_t *wr_rsp)
+/**
+ * @brief  按格式描述解析 PDU
+ *
+ * 先检查固定头部是否完整，再依次读出功能码、各 16 位字段和字节计数，
+ * 数据指针直接指向 buf 中的数据区（零拷贝）。
+ *
+ * @param[in]  buf  源缓冲区（从功能码开始）
+ * @param[in]  len  缓冲区长度
+ * @param[out] pdu  PDU 结构体
+ * @param[in]  fmt  PDU 格式
+ *
+ * @return int
+ *   - >0 : PDU 长度
+ *   -  0 : 固定头部不完整或字节计数超出已接收长度
+ */
+static int modbus_pdu_fmt_parse(const uint8_t *buf, int len, mb_pdu_t *pdu, const mb_pdu_fmt_t *fmt)
 {
-    if (len < 5)
+    if (len < fmt->hlen)
     {
         return(0);
     }
 
-    uint8_t *p = (uint8_t *)buf;
-
-    p += modbus_cvt_u8_get(p, &(wr_rsp->fc));
-    p += modbus_cvt_u16_get(p, &(wr_rsp->addr));
-    p += modbus_cvt_u16_get(p, &(wr_rsp->nb));
-
-    return((int)(p - buf));
-}
-
-static int modbus_pdu_mask_wr_make(uint8_t *buf, const mb_pdu_mask_wr_t *mask_wr)
-{
-    uint8_t *p = buf;
-
-    p += modbus_cvt_u8_put(p, mask_wr->fc);
-    p += modbus_cvt_u16_put(p, mask_wr->addr);
-    p += modbus_cvt_u16_put(p, mask_wr->val_and);
-    p += modbus_cvt_u16_put(p, mask_wr->val_or);
+    uint8_t *d = (uint8_t *)pdu;
+    const uint8_t *p = buf;
 
-    return((int)(p - buf));
-}
-
-static int modbus_pdu_mask_wr_parse(const uint8_t *buf, int len, mb_pdu_mask_wr_t *mask_wr)
-{
-    if (len < 7)
+    p += modbus_cvt_u8_get(p, &(pdu->fc));
+    for (int i=0; i<fmt->nw; i++)
     {
-        return(0);
+        p += modbus_cvt_u16_get(p, (uint16_t *)(d + fmt->w_off[i]));
     }
 
-    uint8_t *p = (uint8_t *)buf;
-
-    p += modbus_cvt_u8_get(p, &(mask_wr->fc));
-    p += modbus_cvt_u16_get(p, &(mask_wr->addr));
-    p += modbus_cvt_u16_get(p, &(mask_wr->val_and));
-    p += modbus_cvt_u16_get(p, &(mask_wr->val_or));
+    if (fmt->dlen_off != 0)
+    {
+        uint8_t dlen;
+        p += modbus_cvt_u8_get(p, &dlen);
+        if ((len - fmt->hlen) < dlen)//字节计数超出已接收长度
+        {
+            return(0);
+        }
+        d[fmt->dlen_off] = dlen;
+        *(uint8_t **)(d + fmt->pdata_off) = (uint8_t *)p;
+        p += dlen;
+    }
 
     return((int)(p - buf));
 }
 
-static int modbus_pdu_wr_rd_req_make(uint8_t *buf, const mb_pdu_wr_rd_req_t *wr_rd_req)
-{
-    uint8_t *p = buf;
 
-    p += modbus_cvt_u8_put(p, wr_rd_req->fc);
-    p += modbus_cvt_u16_put(p, wr_rd_req->rd_addr);
-    p += modbus_cvt_u16_put(p, wr_rd_req->rd_nb);
-    p += modbus_cvt_u16_put(p, wr_rd_req->wr_addr);
-    p += modbus_cvt_u16_put(p, wr_rd_req->wr_nb);
-    p += modbus_cvt_u8_put(p, wr_rd_req->dlen);
-    memcpy(p, wr_rd_req->pdata, wr_rd_req->dlen);
-    p += wr_rd_req->dlen;
-
-    return((int)(p - buf));
-}
-
-static int modbus_pdu_wr_rd_req_parse(const uint8_t *buf, int len, mb_pdu_wr_rd_req_t *wr_rd_req)
+/**
+ * @brief  根据已收到的 PDU 头部预测完整 PDU 长度
+ *
+ * 接收过程中增量调用：功能码和字节计数字段一旦到达即可得出 PDU 总长度，
+ * 接收端据此在最后一个字节到达时立即结束本帧，无需等待字节超时。
+ * 长度规则由功能码描述表给出：固定头部长度，带数据的格式再加字节计数
+ * （字节计数为固定头部的最后一个字节）；异常响应固定为 2。
+ *
+ * @param[in] buf   已接收的 PDU 数据（从功能码开始）
+ * @param[in] len   已接收长度
+ * @param[in] type  PDU 类型（MB_PDU_TYPE_REQ 或 MB_PDU_TYPE_RSP）
+ *
+ * @return int
+ *   - >0 : 完整 PDU 长度
+ *   -  0 : 数据不足, 暂无法判断
+ *   - -1 : 功能码不支持, 只能依靠超时断帧
+ */
+int modbus_pdu_frame_len(const uint8_t *buf, int len, mb_pdu_type_t type)
 {
-    if (len < 11)
+    if (len < 1)
     {
         return(0);
     }
 
-    uint8_t *p = (uint8_t *)buf;
-
-    p += modbus_cvt_u8_get(p, &(wr_rd_req->fc));
-    p += modbus_cvt_u16_get(p, &(wr_rd_req->rd_addr));
-    p += modbus_cvt_u16_get(p, &(wr_rd_req->rd_nb));
-    p += modbus_cvt_u16_get(p, &(wr_rd_req->wr_addr));
-    p += modbus_cvt_u16_get(p, &(wr_rd_req->wr_nb));
-    p += modbus_cvt_u8_get(p, &(wr_rd_req->dlen));
-    wr_rd_req->pdata = p;
-    p += wr_rd_req->dlen;
-
-    return((int)(p - buf));
-}
-
-static int modbus_pdu_req_make(uint8_t *buf, const mb_pdu_t *pdu)//生成pdu请求帧, 返回帧长度, 失败返回0
-{
-    switch(pdu->fc)
+    uint8_t fc = buf[0];
+    if ((type == MB_PDU_TYPE_RSP) && MODBUS_FC_EXCEPT_CHK(fc))
     {
-    case MODBUS_FC_READ_COILS :
-        return(modbus_pdu_rd_req_make(buf, (mb_pdu_rd_req_t *)pdu));
-    case MODBUS_FC_READ_DISCRETE_INPUTS :
-        return(modbus_pdu_rd_req_make(buf, (mb_pdu_rd_req_t *)pdu));
-    case MODBUS_FC_READ_HOLDING_REGISTERS :
-        return(modbus_pdu_rd_req_make(buf, (mb_pdu_rd_req_t *)pdu));
-    case MODBUS_FC_READ_INPUT_REGISTERS :
-        return(modbus_pdu_rd_req_make(buf, (mb_pdu_rd_req_t *)pdu));
-    case MODBUS_FC_WRITE_SINGLE_COIL :
-        return(modbus_pdu_wr_single_make(buf, (mb_pdu_wr_single_t *)pdu));
-    case MODBUS_FC_WRITE_SINGLE_REGISTER :
-        return(modbus_pdu_wr_single_make(buf, (mb_pdu_wr_single_t *)pdu));
-    case MODBUS_FC_READ_EXCEPTION_STATUS :
-        break;
-    case MODBUS_FC_WRITE_MULTIPLE_COILS :
-        return(modbus_pdu_wr_req_make(buf, (mb_pdu_wr_req_t *)pdu));
-    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
-        return(modbus_pdu_wr_req_make(buf, (mb_pdu_wr_req_t *)pdu));
-    case MODBUS_FC_REPORT_SLAVE_ID :
-        break;
-    case MODBUS_FC_MASK_WRITE_REGISTER :
-        return(modbus_pdu_mask_wr_make(buf, (mb_pdu_mask_wr_t *)pdu));
-    case MODBUS_FC_WRITE_AND_READ_REGISTERS :
-        return(modbus_pdu_wr_rd_req_make(buf, (mb_pdu_wr_rd_req_t *)pdu));
-    default:
-        break;
+        return(2);
     }
 
-    return(0);
-}
-
-static int modbus_pdu_req_parse(const uint8_t *buf, int len, mb_pdu_t *pdu)//解析pdu请求帧, 成功返回帧长度, 失败返回-1
-{
-    uint8_t fc = *buf;
-    switch(fc)
+    const mb_pdu_fmt_t *fmt = modbus_pdu_fmt(fc, type);
+    if (fmt == NULL)
+    {
+        return(-1);
+    }
+    if (fmt->dlen_off == 0)
     {
-    case MODBUS_FC_READ_COILS :
-        return(modbus_pdu_rd_req_parse(buf, len, (mb_pdu_rd_req_t *)pdu));
-    case MODBUS_FC_READ_DISCRETE_INPUTS :
-        return(modbus_pdu_rd_req_parse(buf, len, (mb_pdu_rd_req_t *)pdu));
-    case MODBUS_FC_READ_HOLDING_REGISTERS :
-        return(modbus_pdu_rd_req_parse(buf, len, (mb_pdu_rd_req_t *)pdu));
-    case MODBUS_FC_READ_INPUT_REGISTERS :
-        return(modbus_pdu_rd_req_parse(buf, len, (mb_pdu_rd_req_t *)pdu));
-    case MODBUS_FC_WRITE_SINGLE_COIL :
-        return(modbus_pdu_wr_single_parse(buf, len, (mb_pdu_wr_single_t *)pdu));
-    case MODBUS_FC_WRITE_SINGLE_REGISTER :
-        return(modbus_pdu_wr_single_parse(buf, len, (mb_pdu_wr_single_t *)pdu));
-    case MODBUS_FC_READ_EXCEPTION_STATUS :
-        break;
-    case MODBUS_FC_WRITE_MULTIPLE_COILS :
-        return(modbus_pdu_wr_req_parse(buf, len, (mb_pdu_wr_req_t *)pdu));
-    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
-        return(modbus_pdu_wr_req_parse(buf, len, (mb_pdu_wr_req_t *)pdu));
-    case MODBUS_FC_REPORT_SLAVE_ID :
-        break;
-    case MODBUS_FC_MASK_WRITE_REGISTER :
-        return(modbus_pdu_mask_wr_parse(buf, len, (mb_pdu_mask_wr_t *)pdu));
-    case MODBUS_FC_WRITE_AND_READ_REGISTERS :
-        return(modbus_pdu_wr_rd_req_parse(buf, len, (mb_pdu_wr_rd_req_t *)pdu));
-    default:
-        break;
+        return(fmt->hlen);
     }
 
-    return(-1);
+    return((len < fmt->hlen) ? 0 : (fmt->hlen + buf[fmt->hlen - 1]));
 }
 
-static int modbus_pdu_rsp_make(uint8_t *buf, const mb_pdu_t *pdu)//生成pdu响应帧, 返回帧长度, 失败返回0
+int modbus_pdu_make(uint8_t *buf, const mb_pdu_t *pdu, mb_pdu_type_t type)//生成pdu帧, 返回帧长度, 错误返回0
 {
-    if (MODBUS_FC_EXCEPT_CHK(pdu->fc))
+    if ((type == MB_PDU_TYPE_RSP) && MODBUS_FC_EXCEPT_CHK(pdu->fc))
     {
-        return(modbus_pdu_except_make(buf, (mb_pdu_except_t *)pdu));
+        return(modbus_pdu_except_make(buf, &(pdu->exc)));
     }
 
-    switch(pdu->fc)
+    const mb_pdu_fmt_t *fmt = modbus_pdu_fmt(pdu->fc, type);
+    if (fmt == NULL)
     {
-    case MODBUS_FC_READ_COILS :
-        return(modbus_pdu_rd_rsp_make(buf, (mb_pdu_rd_rsp_t *)pdu));
-    case MODBUS_FC_READ_DISCRETE_INPUTS :
-        return(modbus_pdu_rd_rsp_make(buf, (mb_pdu_rd_rsp_t *)pdu));
-    case MODBUS_FC_READ_HOLDING_REGISTERS :
-        return(modbus_pdu_rd_rsp_make(buf, (mb_pdu_rd_rsp_t *)pdu));
-    case MODBUS_FC_READ_INPUT_REGISTERS :
-        return(modbus_pdu_rd_rsp_make(buf, (mb_pdu_rd_rsp_t *)pdu));
-    case MODBUS_FC_WRITE_SINGLE_COIL :
-        return(modbus_pdu_wr_single_make(buf, (mb_pdu_wr_single_t *)pdu));
-    case MODBUS_FC_WRITE_SINGLE_REGISTER :
-        return(modbus_pdu_wr_single_make(buf, (mb_pdu_wr_single_t *)pdu));
-    case MODBUS_FC_READ_EXCEPTION_STATUS :
-        break;
-    case MODBUS_FC_WRITE_MULTIPLE_COILS :
-        return(modbus_pdu_wr_rsp_make(buf, (mb_pdu_wr_rsp_t *)pdu));
-    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
-        return(modbus_pdu_wr_rsp_make(buf, (mb_pdu_wr_rsp_t *)pdu));
-    case MODBUS_FC_REPORT_SLAVE_ID :
-        break;
-    case MODBUS_FC_MASK_WRITE_REGISTER :
-        return(modbus_pdu_mask_wr_make(buf, (mb_pdu_mask_wr_t *)pdu));
-    case MODBUS_FC_WRITE_AND_READ_REGISTERS :
-        return(modbus_pdu_rd_rsp_make(buf, (mb_pdu_rd_rsp_t *)pdu));
-    default:
-        break;
+        return(0);
     }
 
-    return(0);
+    return(modbus_pdu_fmt_make(buf, pdu, fmt));
 }
 
-static int modbus_pdu_rsp_parse(const uint8_t *buf, int len, mb_pdu_t *pdu)//解析pdu响应帧, 成功返回帧长度, 失败返回-1
+int modbus_pdu_parse(const uint8_t *buf, int len, mb_pdu_t *pdu, mb_pdu_type_t type)
 {
-    uint8_t fc = *buf;
-    if (MODBUS_FC_EXCEPT_CHK(fc))
+    if (len < 1)
     {
-        return(modbus_pdu_except_parse(buf, len, (mb_pdu_except_t *)pdu));
+        return(0);
     }
 
-    switch(fc)
+    uint8_t fc = *buf;
+    if ((type == MB_PDU_TYPE_RSP) && MODBUS_FC_EXCEPT_CHK(fc))
     {
-    case MODBUS_FC_READ_COILS :
-        return(modbus_pdu_rd_rsp_parse(buf, len, (mb_pdu_rd_rsp_t *)pdu));
-    case MODBUS_FC_READ_DISCRETE_INPUTS :
-        return(modbus_pdu_rd_rsp_parse(buf, len, (mb_pdu_rd_rsp_t *)pdu));
-    case MODBUS_FC_READ_HOLDING_REGISTERS :
-        return(modbus_pdu_rd_rsp_parse(buf, len, (mb_pdu_rd_rsp_t *)pdu));
-    case MODBUS_FC_READ_INPUT_REGISTERS :
-        return(modbus_pdu_rd_rsp_parse(buf, len, (mb_pdu_rd_rsp_t *)pdu));
-    case MODBUS_FC_WRITE_SINGLE_COIL :
-        return(modbus_pdu_wr_single_parse(buf, len, (mb_pdu_wr_single_t *)pdu));
-    case MODBUS_FC_WRITE_SINGLE_REGISTER :
-        return(modbus_pdu_wr_single_parse(buf, len, (mb_pdu_wr_single_t *)pdu));
-    case MODBUS_FC_READ_EXCEPTION_STATUS :
-        break;
-    case MODBUS_FC_WRITE_MULTIPLE_COILS :
-        return(modbus_pdu_wr_rsp_parse(buf, len, (mb_pdu_wr_rsp_t *)pdu));
-    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
-        return(modbus_pdu_wr_rsp_parse(buf, len, (mb_pdu_wr_rsp_t *)pdu));
-    case MODBUS_FC_REPORT_SLAVE_ID :
-        break;
-    case MODBUS_FC_MASK_WRITE_REGISTER :
-        return(modbus_pdu_mask_wr_parse(buf, len, (mb_pdu_mask_wr_t *)pdu));
-    case MODBUS_FC_WRITE_AND_READ_REGISTERS :
-        return(modbus_pdu_rd_rsp_parse(buf, len, (mb_pdu_rd_rsp_t *)pdu));
-    default:
-        break;
+        return(modbus_pdu_except_parse(buf, len, &(pdu->exc)));
     }
 
-    return(-1);
-}
-
-int modbus_pdu_make(uint8_t *buf, const mb_pdu_t *pdu, mb_pdu_type_t type)//生成pdu帧, 返回帧长度, 错误返回0
-{
-    switch(type)
+    pdu->fc = fc;//不支持时上层以此功能码应答异常
+    const mb_pdu_fmt_t *fmt = modbus_pdu_fmt(fc, type);
+    if (fmt == NULL)
     {
-        case MB_PDU_TYPE_REQ:
-            return(modbus_pdu_req_make(buf, pdu));
-        case MB_PDU_TYPE_RSP:
-            return(modbus_pdu_rsp_make(buf, pdu));
-        default:
-            break;
+        return(-1);
     }
-    return(0);
-}
 
-int modbus_pdu_parse(const uint8_t *buf, int len, mb_pdu_t *pdu, mb_pdu_type_t type)
-{
-    switch(type)
-    {
-        case MB_PDU_TYPE_REQ:
-            return(modbus_pdu_req_parse(buf, len, pdu));
-        case MB_PDU_TYPE_RSP:
-            return(modbus_pdu_rsp_parse(buf, len, pdu));
-        default:
-            break;
-    }
-    return(0);
+    return(modbus_pdu_fmt_parse(buf, len, pdu, fmt));
 }
 
 
 
-
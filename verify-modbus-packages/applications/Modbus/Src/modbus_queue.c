@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+
+#include "bsp_sys.h"
+
+#if (defined(MB_USING_QUEUE) && defined(MB_USING_MASTER))
+
+#define DBG_TAG "mb.queue"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+
+/**
+ * @brief  完成一个请求：写结果、回调、通知等待者
+ */
+static void modbus_queue_finish(mb_queue_t *q, mb_queue_req_t *req, int rst)
+{
+    req->rst = rst;
+    q->done_cnt++;
+    if (req->cb != NULL)
+    {
+        req->cb(req);
+    }
+    if (req->done != NULL)
+    {
+        rt_completion_done(req->done);
+    }
+}
+
+
+/**
+ * @brief  总线线程
+ *
+ * 独占实例，按队列顺序逐个执行请求；前一个请求完成后立即取下一个，
+ * 多个提交线程的请求在总线上首尾相接，不需要各自加锁等待。
+ * 收到空请求（销毁）时退出，队列中剩余请求以结果 0 完成。
+ */
+static void modbus_queue_thread(void *args)
+{
+    mb_queue_t *q = (mb_queue_t *)args;
+    mb_queue_req_t *req;
+
+    while(q->run)
+    {
+        if (rt_mq_recv(q->mq, &req, sizeof(req), RT_WAITING_FOREVER) != sizeof(req))
+        {
+            continue;
+        }
+        if (req == NULL)//销毁
+        {
+            break;
+        }
+        modbus_queue_finish(q, req, modbus_master_call(q->hinst, req->saddr, req->fc, req->addr, req->nb, req->pdata));
+    }
+
+    while(rt_mq_recv(q->mq, &req, sizeof(req), 0) == sizeof(req))
+    {
+        if (req != NULL)
+        {
+            modbus_queue_finish(q, req, 0);
+        }
+    }
+
+    rt_completion_done(&(q->exit));
+}
+
+
+/**
+ * @brief  创建主机请求队列
+ *
+ * 为一个实例（一条总线或一个 TCP 连接）创建总线线程，应用线程通过队列提交请求，
+ * 实例的收发缓冲区只由总线线程访问，多个应用线程共享同一个 RS-485 口时不会互相破坏。
+ *
+ * @param[in] hinst       Modbus 实例（创建后不要再在其它线程中直接调用）
+ * @param[in] depth       队列深度（最多排队的请求数）
+ * @param[in] stack_size  总线线程栈大小
+ * @param[in] prio        总线线程优先级
+ *
+ * @return mb_queue_t*  成功返回队列指针，失败返回 NULL
+ *
+ * @note
+ *   - 请求结构体由提交者分配，完成前须保持有效
+ *   - 完成时先调用 cb，再通知 done
+ */
+mb_queue_t *modbus_queue_create(mb_inst_t *hinst, int depth, int stack_size, int prio)
+{
+    if ((hinst == NULL) || (depth <= 0))
+    {
+        return(NULL);
+    }
+
+    mb_queue_t *q = calloc(1, sizeof(mb_queue_t));
+    if (q == NULL)
+    {
+        return(NULL);
+    }
+
+    q->hinst = hinst;
+    q->run = 1;
+    rt_completion_init(&(q->exit));
+    q->mq = rt_mq_create("mb_q", sizeof(mb_queue_req_t *), depth + 1, RT_IPC_FLAG_PRIO);//多留一个给销毁消息
+    if (q->mq == RT_NULL)
+    {
+        free(q);
+        return(NULL);
+    }
+    q->tid = rt_thread_create("mb_bus", modbus_queue_thread, q, stack_size, prio, 20);
+    if (q->tid == RT_NULL)
+    {
+        rt_mq_delete(q->mq);
+        free(q);
+        return(NULL);
+    }
+    rt_thread_startup(q->tid);
+
+    return(q);
+}
+
+
+/**
+ * @brief  销毁主机请求队列
+ *
+ * 等待正在执行的请求完成后退出总线线程，未执行的请求以结果 0 完成。
+ *
+ * @param[in] q  队列指针
+ *
+ * @warning
+ *   - 须在所有提交线程停止提交后调用
+ */
+void modbus_queue_destroy(mb_queue_t *q)
+{
+    if (q == NULL)
+    {
+        return;
+    }
+
+    mb_queue_req_t *req = NULL;
+    q->run = 0;
+    while(rt_mq_urgent(q->mq, &req, sizeof(req)) != RT_EOK)//队列满时等总线线程腾出空位
+    {
+        rt_thread_mdelay(1);
+    }
+    rt_completion_wait(&(q->exit), RT_WAITING_FOREVER);
+
+    rt_mq_delete(q->mq);
+    free(q);
+}
+
+
+/**
+ * @brief  请求入队（不修改 req->done）
+ *
+ * @param[in] q     队列指针
+ * @param[in] req   请求
+ * @param[in] prio  优先级
+ *
+ * @return int  0-成功，-1-队列已满
+ */
+static int modbus_queue_post(mb_queue_t *q, mb_queue_req_t *req, int prio)
+{
+    req->rst = 0;
+    rt_err_t rst;
+    if (prio == MB_QUEUE_PRIO_HIGH)
+    {
+        rst = rt_mq_urgent(q->mq, &req, sizeof(req));
+    }
+    else
+    {
+        rst = rt_mq_send(q->mq, &req, sizeof(req));
+    }
+    if (rst != RT_EOK)
+    {
+        LOG_W("queue full, request dropped.");
+        return(-1);
+    }
+
+    return(0);
+}
+
+
+/**
+ * @brief  异步提交请求
+ *
+ * @param[in] q     队列指针
+ * @param[in] req   请求（完成前须保持有效），done 由本函数清为 NULL
+ * @param[in] prio  MB_QUEUE_PRIO_HIGH 插到队首，MB_QUEUE_PRIO_NORMAL 排到队尾
+ *
+ * @return int  0-成功，-1-参数错误或队列已满
+ */
+int modbus_queue_submit(mb_queue_t *q, mb_queue_req_t *req, int prio)
+{
+    if ((q == NULL) || (req == NULL) || (! q->run))
+    {
+        return(-1);
+    }
+
+    // 异步请求不等待完成, 清除复用请求中可能残留的完成量指针
+    req->done = NULL;
+    return(modbus_queue_post(q, req, prio));
+}
+
+
+/**
+ * @brief  同步提交请求并等待完成
+ *
+ * 调用者阻塞直到总线线程执行完该请求，适合替换原来直接调用实例的同步接口。
+ *
+ * @param[in]     q     队列指针
+ * @param[in,out] req   请求，done 由本函数设置
+ * @param[in]     prio  优先级
+ *
+ * @return int  req->rst，提交失败返回 0
+ */
+int modbus_queue_call(mb_queue_t *q, mb_queue_req_t *req, int prio)
+{
+    if ((q == NULL) || (req == NULL) || (! q->run))
+    {
+        return(0);
+    }
+
+    struct rt_completion done;
+    rt_completion_init(&done);
+    req->done = &done;
+    if (modbus_queue_post(q, req, prio) < 0)
+    {
+        req->done = NULL;
+        return(0);
+    }
+    rt_completion_wait(&done, RT_WAITING_FOREVER);
+    req->done = NULL;
+
+    return(req->rst);
+}
+
+#endif
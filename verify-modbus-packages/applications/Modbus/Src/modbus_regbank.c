@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+
+#include "bsp_sys.h"
+
+#ifdef MB_USING_REGBANK
+
+
+/**
+ * @brief  比较两个区的排序键（类型, 起始地址）
+ */
+static int modbus_regbank_cmp(mb_reg_type_t type_a, uint16_t base_a, mb_reg_type_t type_b, uint16_t base_b)
+{
+    if (type_a != type_b)
+    {
+        return((type_a < type_b) ? -1 : 1);
+    }
+    if (base_a != base_b)
+    {
+        return((base_a < base_b) ? -1 : 1);
+    }
+    return(0);
+}
+
+
+/**
+ * @brief  初始化寄存器库
+ *
+ * 应用以声明方式描述存储区（类型、起始地址、数量、存储指针、写入钩子），
+ * 从站直接按区表应答请求，不再逐个寄存器调用回调函数。
+ * 区表按（类型, 起始地址）原地排序，查找使用二分法。
+ *
+ * @param[out]    bank     寄存器库
+ * @param[in,out] regions  区表（须在寄存器库使用期间保持有效）
+ * @param[in]     num      区数量
+ *
+ * @return int
+ *   -  0 : 成功
+ *   - -1 : 参数错误或同类型区地址重叠
+ *
+ * @note
+ *   - 区表通常只有几项，使用插入排序
+ *   - 一个请求须完整落在一个区内，跨越相邻区的请求以地址错误应答
+ */
+int modbus_regbank_init(mb_regbank_t *bank, mb_reg_region_t *regions, int num)
+{
+    if ((bank == NULL) || (regions == NULL) || (num <= 0))
+    {
+        return(-1);
+    }
+
+    // 1. 按(类型, 起始地址)插入排序
+    for (int i=1; i<num; i++)
+    {
+        mb_reg_region_t tmp = regions[i];
+        int j = i - 1;
+        while((j >= 0) && (modbus_regbank_cmp(regions[j].type, regions[j].base, tmp.type, tmp.base) > 0))
+        {
+            regions[j + 1] = regions[j];
+            j--;
+        }
+        regions[j + 1] = tmp;
+    }
+
+    // 2. 检查参数及同类型区重叠
+    for (int i=0; i<num; i++)
+    {
+        if ((regions[i].type >= MB_REG_TYPE_MAX) || (regions[i].ptr == NULL) || (regions[i].count == 0))
+        {
+            return(-1);
+        }
+        if ((i > 0) && (regions[i].type == regions[i - 1].type)
+            && ((uint32_t)regions[i - 1].base + regions[i - 1].count > regions[i].base))
+        {
+            return(-1);
+        }
+    }
+
+    bank->regions = regions;
+    bank->num = num;
+
+    return(0);
+}
+
+
+/**
+ * @brief  查找完整包含 [addr, addr+nb) 的区
+ *
+ * 二分查找最后一个（类型, 起始地址）不大于（type, addr）的区，再检查范围。
+ *
+ * @param[in] bank  寄存器库
+ * @param[in] type  区类型
+ * @param[in] addr  起始地址
+ * @param[in] nb    数量
+ *
+ * @return const mb_reg_region_t*  找到返回区指针，否则返回 NULL
+ */
+const mb_reg_region_t *modbus_regbank_find(const mb_regbank_t *bank, mb_reg_type_t type, uint16_t addr, int nb)
+{
+    if ((bank == NULL) || (bank->regions == NULL) || (nb <= 0))
+    {
+        return(NULL);
+    }
+
+    int lo = 0;
+    int hi = bank->num - 1;
+    int idx = -1;
+    while(lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        const mb_reg_region_t *r = &(bank->regions[mid]);
+        if (modbus_regbank_cmp(r->type, r->base, type, addr) <= 0)
+        {
+            idx = mid;
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    if (idx < 0)
+    {
+        return(NULL);
+    }
+
+    const mb_reg_region_t *r = &(bank->regions[idx]);
+    if ((r->type != type) || (((uint32_t)addr + nb) > ((uint32_t)r->base + r->count)))
+    {
+        return(NULL);
+    }
+
+    return(r);
+}
+
+
+/**
+ * @brief  从位表的任意位偏移处拷贝 nb 位到另一个位表的任意偏移处
+ *
+ * 两端都按字节对齐时整字节拷贝，只处理末字节的剩余位。
+ */
+static void modbus_regbank_bits_copy(uint8_t *dst, int dst_off, const uint8_t *src, int src_off, int nb)
+{
+    if (((dst_off & 7) == 0) && ((src_off & 7) == 0))
+    {
+        int bytes = nb / 8;
+        memcpy(dst + dst_off / 8, src + src_off / 8, bytes);
+        dst_off += bytes * 8;
+        src_off += bytes * 8;
+        nb -= bytes * 8;
+    }
+
+    for (int i=0; i<nb; i++)
+    {
+        modbus_bitmap_set(dst, dst_off + i, modbus_bitmap_get(src, src_off + i));
+    }
+}
+
+
+/**
+ * @brief  从寄存器库读取数据
+ *
+ * 寄存器按块转换为大端序，位按块拷贝为低位在前的位表。
+ *
+ * @param[in]  bank   寄存器库
+ * @param[in]  type   区类型
+ * @param[in]  addr   起始地址
+ * @param[in]  nb     数量
+ * @param[out] pdata  输出数据（寄存器 nb×2 字节，位 (nb+7)/8 字节）
+ *
+ * @return int
+ *   -  0 : 成功
+ *   - -2 : 地址错误（不在任何区内）
+ */
+int modbus_regbank_read(const mb_regbank_t *bank, mb_reg_type_t type, uint16_t addr, int nb, uint8_t *pdata)
+{
+    const mb_reg_region_t *r = modbus_regbank_find(bank, type, addr, nb);
+    if (r == NULL)
+    {
+        return(-2);
+    }
+
+    int off = addr - r->base;
+    if ((type == MB_REG_TYPE_COIL) || (type == MB_REG_TYPE_DISC))
+    {
+        memset(pdata, 0, (nb + 7) / 8);
+        modbus_regbank_bits_copy(pdata, 0, (const uint8_t *)r->ptr, off, nb);
+    }
+    else
+    {
+        modbus_cvt_u16_put_block(pdata, (const uint16_t *)r->ptr + off, nb);
+    }
+
+    return(0);
+}
+
+
+/**
+ * @brief  向寄存器库写入数据
+ *
+ * 区配置了写入钩子时先调用钩子，钩子返回负值则不写入。
+ *
+ * @param[in] bank   寄存器库
+ * @param[in] type   区类型（MB_REG_TYPE_COIL 或 MB_REG_TYPE_HOLD）
+ * @param[in] addr   起始地址
+ * @param[in] nb     数量
+ * @param[in] pdata  写入数据（寄存器为大端序，位为低位在前的位表）
+ *
+ * @return int
+ *   -  0 : 成功
+ *   - -2 : 地址错误（不在任何区内或区类型不可写）
+ *   - <0 : 写入钩子返回值
+ */
+int modbus_regbank_write(const mb_regbank_t *bank, mb_reg_type_t type, uint16_t addr, int nb, const uint8_t *pdata)
+{
+    if ((type != MB_REG_TYPE_COIL) && (type != MB_REG_TYPE_HOLD))
+    {
+        return(-2);
+    }
+
+    const mb_reg_region_t *r = modbus_regbank_find(bank, type, addr, nb);
+    if (r == NULL)
+    {
+        return(-2);
+    }
+
+    if (r->on_write != NULL)
+    {
+        int rst = r->on_write(addr, nb, pdata);
+        if (rst < 0)
+        {
+            return(rst);
+        }
+    }
+
+    int off = addr - r->base;
+    if (type == MB_REG_TYPE_COIL)
+    {
+        modbus_regbank_bits_copy((uint8_t *)r->ptr, off, pdata, 0, nb);
+    }
+    else
+    {
+        modbus_cvt_u16_get_block(pdata, (uint16_t *)r->ptr + off, nb);
+    }
+
+    return(0);
+}
+
+#endif
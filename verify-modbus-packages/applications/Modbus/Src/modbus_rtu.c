@@ -36,10 +36,28 @@
  *   - 无错误检查，假设输入有效；如果 pdu 无效，返回长度可能为 0
  */
 int modbus_rtu_frame_make(uint8_t *buf, const mb_rtu_frm_t *frm, mb_pdu_type_t type)
+{
+    int pdu_len = modbus_pdu_make(buf + MB_RTU_SADDR_SIZE, &(frm->pdu), type);
+    return(modbus_rtu_frame_seal(buf, frm->saddr, pdu_len));
+}
+
+/**
+ * @brief  封装已写入缓冲区的 PDU 为 RTU 帧
+ *
+ * 零拷贝编码：调用者直接在 buf + MB_RTU_SADDR_SIZE 处写入 PDU，
+ * 本函数填写从机地址并在 PDU 之后原地追加 CRC，不再经过中间缓冲区。
+ *
+ * @param[in,out] buf      帧缓冲区（PDU 已写入 buf + MB_RTU_SADDR_SIZE 处）
+ * @param[in]     saddr    从机地址
+ * @param[in]     pdu_len  PDU 长度
+ *
+ * @return int  帧总长度（地址 + PDU + CRC）
+ */
+int modbus_rtu_frame_seal(uint8_t *buf, uint8_t saddr, int pdu_len)
 {
     uint8_t *p = buf;
-    p += modbus_cvt_u8_put(p, frm->saddr);
-    p += modbus_pdu_make(p, &(frm->pdu), type);
+    p += modbus_cvt_u8_put(p, saddr);
+    p += pdu_len;
     uint16_t crc = modbus_crc_cal(buf, (int)(p - buf));
     *p++ = crc;
     *p++ = (crc >> 8);
@@ -68,6 +86,29 @@ int modbus_rtu_frame_make(uint8_t *buf, const mb_rtu_frm_t *frm, mb_pdu_type_t t
  *   - 输入 buf 必须完整；部分帧可能导致 CRC 通过但 PDU 错位
  */
 int modbus_rtu_frame_parse(const uint8_t *buf, int len, mb_rtu_frm_t *frm, mb_pdu_type_t type)
+{
+    return(modbus_rtu_frame_parse_crc(buf, len, frm, type, -1));
+}
+
+
+/**
+ * @brief  解析 RTU 帧，使用接收时已得到的 CRC 校验结果
+ *
+ * 接收中断已逐字节累计 CRC 时，整帧（含 CRC）余数为 0 即校验正确，
+ * 帧结束后只需 O(1) 判断，不必再遍历整帧。
+ *
+ * @param[in]  buf     输入缓冲区（包含完整 RTU 帧）
+ * @param[in]  len     输入缓冲区长度
+ * @param[out] frm     输出 RTU 帧结构体
+ * @param[in]  type    PDU 类型
+ * @param[in]  crc_ok  接收中断累计的 len 字节的校验结果：1-正确，0-错误，-1-未知
+ *
+ * @return int  同 modbus_rtu_frame_parse()
+ *
+ * @note
+ *   - 仅当解析出的帧长度正好为 len 时使用 crc_ok，否则仍计算 CRC
+ */
+int modbus_rtu_frame_parse_crc(const uint8_t *buf, int len, mb_rtu_frm_t *frm, mb_pdu_type_t type, int crc_ok)
 {
     if (len < MB_RTU_FRM_MIN){
         return(0);
@@ -76,8 +117,16 @@ int modbus_rtu_frame_parse(const uint8_t *buf, int len, mb_rtu_frm_t *frm, mb_pd
     frm->saddr = *buf;
     int remain = len - (MB_RTU_SADDR_SIZE + MB_RTU_CRC_SIZE);
     int pdu_len = modbus_pdu_parse(buf + 1, remain, &(frm->pdu), type);
-    if (pdu_len <= 0){
-        return(pdu_len);
+    if (pdu_len < 0)//功能码不支持, 校验正确才报告, 线路噪声按帧错误丢弃
+    {
+        if (crc_ok < 0)
+        {
+            crc_ok = (modbus_crc_cal(buf, len) == 0) ? 1 : 0;
+        }
+        return(crc_ok ? -1 : 0);
+    }
+    if (pdu_len == 0){
+        return(0);
     }
 
     if (remain < pdu_len){
@@ -85,8 +134,11 @@ int modbus_rtu_frame_parse(const uint8_t *buf, int len, mb_rtu_frm_t *frm, mb_pd
     }
 
     int flen = pdu_len + (MB_RTU_SADDR_SIZE + MB_RTU_CRC_SIZE);
-    uint16_t cal_crc = modbus_crc_cal(buf, flen);
-    if (cal_crc != 0)
+    if ((flen != len) || (crc_ok < 0))//接收时未得到本帧的校验结果
+    {
+        crc_ok = (modbus_crc_cal(buf, flen) == 0) ? 1 : 0;
+    }
+    if (crc_ok == 0)
     {
         return(0);
     }
@@ -94,6 +146,35 @@ int modbus_rtu_frame_parse(const uint8_t *buf, int len, mb_rtu_frm_t *frm, mb_pd
     return(pdu_len);
 }
 
+/**
+ * @brief  根据已收到的数据预测完整 RTU 帧长度
+ *
+ * 帧长度 = 地址(1) + PDU 长度 + CRC(2)，PDU 长度由 modbus_pdu_frame_len() 给出。
+ * 作为后端接收的帧长度预测函数，使接收在最后一个 CRC 字节到达时立即返回。
+ *
+ * @param[in] buf   已接收的数据（从从机地址开始）
+ * @param[in] len   已接收长度
+ * @param[in] type  PDU 类型（mb_pdu_type_t）
+ *
+ * @return int
+ *   - >0 : 完整帧长度
+ *   -  0 : 数据不足, 暂无法判断
+ *   - -1 : 功能码不支持
+ */
+int modbus_rtu_frame_len(const uint8_t *buf, int len, int type)
+{
+    if (len <= MB_RTU_SADDR_SIZE){
+        return(0);
+    }
+
+    int pdu_len = modbus_pdu_frame_len(buf + MB_RTU_SADDR_SIZE, len - MB_RTU_SADDR_SIZE, (mb_pdu_type_t)type);
+    if (pdu_len <= 0){
+        return(pdu_len);
+    }
+
+    return(MB_RTU_SADDR_SIZE + pdu_len + MB_RTU_CRC_SIZE);
+}
+
 #endif
 
 
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+
+#include "bsp_sys.h"
+
+#if (defined(MB_USING_SCHED) && defined(MB_USING_MASTER))
+
+#define DBG_TAG "mb.sched"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+
+/**
+ * @brief  清除统计
+ *
+ * @param[in,out] s  调度器
+ */
+void modbus_sched_reset_stat(mb_sched_t *s)
+{
+    MB_ASSERT(s != NULL);
+
+    for (int i=0; i<s->num; i++)
+    {
+        mb_poll_t *pt = &(s->table[i]);
+        pt->run_cnt = 0;
+        pt->miss_cnt = 0;
+        pt->err_cnt = 0;
+        pt->cycle_ms = 0;
+        pt->cycle_max_ms = 0;
+        pt->cost_ms = 0;
+        pt->cost_max_ms = 0;
+    }
+    s->start_ms = modbus_port_get_ms();
+    s->busy_ms = 0;
+}
+
+
+/**
+ * @brief  初始化主机周期轮询调度器
+ *
+ * 应用以表的形式描述轮询点（从机、功能码、地址、数量、周期、优先级），
+ * 调度器按最早截止时间优先（EDF）连续驱动总线：每个轮询点每周期释放一次，
+ * 截止时间为释放时间加一个周期，已释放的点中截止时间最早者先执行。
+ * 总线负载不超过 100% 时每个点都能在截止时间前完成。
+ *
+ * @param[out]    s      调度器
+ * @param[in]     hinst  主机实例
+ * @param[in,out] table  轮询点表（须在调度器使用期间保持有效）
+ * @param[in]     num    轮询点数量
+ *
+ * @return int
+ *   -  0 : 成功
+ *   - -1 : 参数错误
+ */
+int modbus_sched_init(mb_sched_t *s, mb_inst_t *hinst, mb_poll_t *table, int num)
+{
+    if ((s == NULL) || (hinst == NULL) || (table == NULL) || (num <= 0))
+    {
+        return(-1);
+    }
+    for (int i=0; i<num; i++)
+    {
+        if ((table[i].period_ms <= 0) || (table[i].pdata == NULL))
+        {
+            return(-1);
+        }
+    }
+
+    s->hinst = hinst;
+    s->table = table;
+    s->num = num;
+    modbus_sched_reset_stat(s);
+
+    for (int i=0; i<num; i++)
+    {
+        table[i].next_ms = s->start_ms;
+        table[i].last_ms = 0;
+    }
+
+    return(0);
+}
+
+
+/**
+ * @brief  选择截止时间最早的已释放轮询点
+ *
+ * @param[in]  s        调度器
+ * @param[in]  now      当前时间
+ * @param[out] pwake    无已释放点时，返回最早的释放时间
+ *
+ * @return mb_poll_t*  已释放点中截止时间最早者（相同时优先级数值小者），无则返回 NULL
+ */
+static mb_poll_t *modbus_sched_pick(const mb_sched_t *s, long long now, long long *pwake)
+{
+    mb_poll_t *best = NULL;
+    long long best_dl = 0;
+    long long wake = 0;
+
+    for (int i=0; i<s->num; i++)
+    {
+        mb_poll_t *pt = &(s->table[i]);
+        if (pt->next_ms > now)//未释放
+        {
+            if ((wake == 0) || (pt->next_ms < wake))
+            {
+                wake = pt->next_ms;
+            }
+            continue;
+        }
+
+        long long dl = pt->next_ms + pt->period_ms;
+        if ((best == NULL) || (dl < best_dl) || ((dl == best_dl) && (pt->prio < best->prio)))
+        {
+            best = pt;
+            best_dl = dl;
+        }
+    }
+
+    *pwake = wake;
+    return(best);
+}
+
+
+/**
+ * @brief  调度处理
+ *
+ * 执行一个截止时间最早的已释放轮询点并更新统计；没有已释放的点时
+ * 睡眠到最早的释放时间（最多 tmo_ms）。在线程中循环调用即可。
+ *
+ * @param[in,out] s       调度器
+ * @param[in]     tmo_ms  无可执行点时最长等待时间（毫秒）
+ *
+ * @return int  执行结果（同对应的同步接口），本次未执行返回 0
+ *
+ * @note
+ *   - 完成时间晚于截止时间记为一次错过（miss），落后超过一个周期而跳过的每次释放也各记一次
+ *   - 落后超过一个周期的点不补发，直接以当前时间重新释放，避免过载后突发
+ */
+int modbus_sched_poll(mb_sched_t *s, int tmo_ms)
+{
+    MB_ASSERT(s != NULL);
+
+    // 1. 选择执行的轮询点, 无则睡眠到最早释放时间
+    long long now = modbus_port_get_ms();
+    long long wake = 0;
+    mb_poll_t *pt = modbus_sched_pick(s, now, &wake);
+    if (pt == NULL)
+    {
+        int dly = (int)(wake - now);
+        if (dly > tmo_ms)
+        {
+            dly = tmo_ms;
+        }
+        if (dly > 0)
+        {
+            modbus_port_delay_ms(dly);
+        }
+        return(0);
+    }
+
+    // 2. 执行请求
+    long long dl = pt->next_ms + pt->period_ms;
+    int rst = modbus_master_call(s->hinst, pt->saddr, pt->fc, pt->addr, pt->nb, pt->pdata);
+    long long end = modbus_port_get_ms();
+
+    // 3. 更新统计
+    if (pt->run_cnt > 0)
+    {
+        pt->cycle_ms = (int)(now - pt->last_ms);
+        if (pt->cycle_ms > pt->cycle_max_ms)
+        {
+            pt->cycle_max_ms = pt->cycle_ms;
+        }
+    }
+    pt->cost_ms = (int)(end - now);
+    if (pt->cost_ms > pt->cost_max_ms)
+    {
+        pt->cost_max_ms = pt->cost_ms;
+    }
+    pt->last_ms = now;
+    pt->run_cnt++;
+    s->busy_ms += pt->cost_ms;
+    if (rst <= 0)
+    {
+        pt->err_cnt++;
+    }
+    if (end > dl)
+    {
+        pt->miss_cnt++;
+        LOG_D("slave %d fc %d addr %d miss deadline by %d ms.", pt->saddr, pt->fc, pt->addr, (int)(end - dl));
+    }
+
+    // 4. 计算下次释放时间, 落后超过一个周期时不补发, 跳过的释放计入错过截止时间次数
+    pt->next_ms += pt->period_ms;
+    if (pt->next_ms + pt->period_ms <= end)
+    {
+        pt->miss_cnt += (uint32_t)((end - pt->next_ms) / pt->period_ms);
+        pt->next_ms = end;
+    }
+
+    if (pt->cb != NULL)
+    {
+        pt->cb(pt, rst);
+    }
+
+    return(rst);
+}
+
+
+/**
+ * @brief  打印调度统计
+ *
+ * 每个轮询点一行：配置周期、实际周期（最近/最大）、执行耗时（最近/最大）、
+ * 执行次数、失败次数和错过截止时间次数，最后打印总线占用率。
+ *
+ * @param[in] s  调度器
+ */
+void modbus_sched_dump(const mb_sched_t *s)
+{
+    MB_ASSERT(s != NULL);
+
+    MB_PRINTF("idx slave fc  addr   nb period cycle/max   cost/max     run      err     miss\n");
+    for (int i=0; i<s->num; i++)
+    {
+        const mb_poll_t *pt = &(s->table[i]);
+        MB_PRINTF("%3d %5d %2d %5d %4d %6d %5d/%-5d %4d/%-5d %8u %8u %8u\n",
+                  i, pt->saddr, pt->fc, pt->addr, pt->nb, pt->period_ms,
+                  pt->cycle_ms, pt->cycle_max_ms, pt->cost_ms, pt->cost_max_ms,
+                  (unsigned)pt->run_cnt, (unsigned)pt->err_cnt, (unsigned)pt->miss_cnt);
+    }
+
+    long long span = modbus_port_get_ms() - s->start_ms;
+    int load = (span > 0) ? (int)(s->busy_ms * 1000 / span) : 0;
+    MB_PRINTF("bus load %d.%d%% over %d ms\n", load / 10, load % 10, (int)span);
+}
+
+#endif
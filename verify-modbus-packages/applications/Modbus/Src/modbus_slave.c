@@ -55,6 +55,18 @@ MB_WEAK int modbus_port_write_hold(uint16_t addr, uint16_t reg)//写保持寄存
 
 
 
+/**
+ * @brief  取发送缓冲区中读响应数据区的位置（PDU 功能码和字节计数之后）
+ *
+ * 读类请求的参数在解析时已取出，响应数据直接写入此处，
+ * 封帧时 modbus_pdu_rd_rsp_make() 检测到数据已在原位便不再拷贝。
+ */
+static uint8_t *modbus_slave_rsp_data(mb_inst_t *hinst)
+{
+    return(modbus_frame_pdu(hinst) + 2);
+}
+
+
 /**
  * @brief  处理 Modbus 从站读线圈请求（功能码 0x01）
  *
@@ -72,14 +84,13 @@ MB_WEAK int modbus_port_write_hold(uint16_t addr, uint16_t reg)//写保持寄存
  *
  * @note
  *   - 依赖用户注册的回调函数 hinst->cb->read_coil(addr, &bit)
- *   - 响应数据使用 hinst->datas 作为临时位图缓冲区（低位在前，符合 Modbus 规范）
+ *   - 位图直接写入发送缓冲区的响应数据区（低位在前，符合 Modbus 规范），封帧时无需拷贝
  *   - 位图字节数 = (nb + 7) / 8，向上取整
  *   - 上层调用 modbus_rtu_frame_make() 会自动添加地址字段和 CRC
  *
  * @warning
  *   - 若未注册 read_coil 回调，返回异常码 0x04（从站设备故障）
  *   - 用户回调返回负值时，自动转换为 Modbus 标准异常码（如 -2 → 0x02）
- *   - hinst->datas 必须足够大（至少 256 字节），否则可能溢出
  */
 static void modbus_slave_pdu_deal_read_coils(mb_inst_t *hinst, mb_pdu_t *pdu)
 {
@@ -95,8 +106,9 @@ static void modbus_slave_pdu_deal_read_coils(mb_inst_t *hinst, mb_pdu_t *pdu)
     uint16_t addr = pdu->rd_req.addr;
     // 3. 要读取的线圈数量（如 8）
     int nb = pdu->rd_req.nb;
-    // 4. 清空临时缓冲区
-    memset(hinst->datas, 0, sizeof(hinst->datas));
+    // 4. 清空响应数据区
+    uint8_t *pdata = modbus_slave_rsp_data(hinst);
+    memset(pdata, 0, (nb + 7) / 8);
     for (int i=0; i<nb; i++)
     {
         uint8_t bit;
@@ -107,11 +119,11 @@ static void modbus_slave_pdu_deal_read_coils(mb_inst_t *hinst, mb_pdu_t *pdu)
             pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
             return;
         }
-        modbus_bitmap_set(hinst->datas, i, bit);
+        modbus_bitmap_set(pdata, i, bit);
     }
 
     pdu->rd_rsp.dlen = (nb + 7) / 8;
-    pdu->rd_rsp.pdata = hinst->datas;
+    pdu->rd_rsp.pdata = pdata;
 }
 
 
@@ -133,7 +145,7 @@ static void modbus_slave_pdu_deal_read_coils(mb_inst_t *hinst, mb_pdu_t *pdu)
  *
  * @note
  *   - 依赖用户注册的回调函数 hinst->cb->read_disc(addr, &bit)
- *   - 响应数据使用 hinst->datas 作为临时位图缓冲区（低位在前，符合 Modbus 规范）
+ *   - 位图直接写入发送缓冲区的响应数据区（低位在前，符合 Modbus 规范），封帧时无需拷贝
  *   - 位图字节数 = (nb + 7) / 8，向上取整
  *   - 与读线圈（0x01）逻辑完全相同，仅功能码和回调函数不同
  *   - 上层调用 modbus_rtu_frame_make() 会自动添加地址字段和 CRC
@@ -141,7 +153,6 @@ static void modbus_slave_pdu_deal_read_coils(mb_inst_t *hinst, mb_pdu_t *pdu)
  * @warning
  *   - 若未注册 read_disc 回调，返回异常码 0x04（从站设备故障）
  *   - 用户回调返回负值时，自动转换为 Modbus 标准异常码（如 -2 → 0x02）
- *   - hinst->datas 必须足够大（至少 256 字节），否则可能溢出
  *   - 离散输入地址空间独立于线圈地址空间
  */
 static void modbus_slave_pdu_deal_read_discs(mb_inst_t *hinst, mb_pdu_t *pdu)
@@ -158,8 +169,9 @@ static void modbus_slave_pdu_deal_read_discs(mb_inst_t *hinst, mb_pdu_t *pdu)
     /* 2. 提取请求参数 */
     uint16_t addr = pdu->rd_req.addr;   // 起始离散输入地址（0 开始）
     int nb = pdu->rd_req.nb;            // 要读取的输入数量
-    /* 3. 清空临时数据缓冲区，防止旧数据干扰 */
-    memset(hinst->datas, 0, sizeof(hinst->datas));
+    /* 3. 清空响应数据区，防止旧数据干扰 */
+    uint8_t *pdata = modbus_slave_rsp_data(hinst);
+    memset(pdata, 0, (nb + 7) / 8);
     /* 4. 遍历每个离散输入，调用用户回调获取状态 */
     for (int i=0; i<nb; i++)
     {
@@ -175,11 +187,11 @@ static void modbus_slave_pdu_deal_read_discs(mb_inst_t *hinst, mb_pdu_t *pdu)
             return;
         }
         /* 将 bit 写入位图缓冲区（低位在前） */
-        modbus_bitmap_set(hinst->datas, i, bit);
+        modbus_bitmap_set(pdata, i, bit);
     }
     /* 5. 构造响应字段 */
     pdu->rd_rsp.dlen = (nb + 7) / 8;    // 位图字节数：每 8 位占 1 字节，向上取整
-    pdu->rd_rsp.pdata = hinst->datas;   // 指向位图数据首地址
+    pdu->rd_rsp.pdata = pdata;          // 指向位图数据首地址
 
     /* 响应格式示例（nb=10）：
          *   [FC=0x02][字节计数=2][位图数据 2 字节]
@@ -188,6 +200,97 @@ static void modbus_slave_pdu_deal_read_discs(mb_inst_t *hinst, mb_pdu_t *pdu)
 }
 
 
+/**
+ * @brief  读连续寄存器并以大端序写入数据缓冲区
+ *
+ * 注册了批量回调时只调用一次（一次越界检查 + 一次块拷贝），
+ * 否则逐个调用单寄存器回调。
+ *
+ * @param[in]  hinst   从站实例（批量回调使用 hinst->datas 作为对齐的主机序暂存区）
+ * @param[in]  range   批量读回调，可为 NULL
+ * @param[in]  single  单寄存器读回调，可为 NULL
+ * @param[in]  addr    起始地址
+ * @param[in]  nb      寄存器数量
+ * @param[out] pdata   输出缓冲区（大端序），可为发送缓冲区中任意字节位置
+ *
+ * @return int  0-成功, <0-异常码取负（两种回调都未注册时返回从站设备故障）
+ */
+static int modbus_slave_regs_read(mb_inst_t *hinst, modbus_read_regs_t range, modbus_read_reg_t single, uint16_t addr, int nb, uint8_t *pdata)
+{
+    if (range != NULL)
+    {
+        uint16_t *pregs = (uint16_t *)hinst->datas;
+        int rst = range(addr, nb, pregs);
+        if (rst < 0)
+        {
+            return(rst);
+        }
+        modbus_cvt_u16_put_block(pdata, pregs, nb);
+        return(0);
+    }
+
+    if (single == NULL)
+    {
+        return(-MODBUS_EC_SLAVE_OR_SERVER_FAILURE);
+    }
+
+    uint8_t *p = pdata;
+    for (int i=0; i<nb; i++)
+    {
+        uint16_t val;
+        int rst = single(addr + i, &val);
+        if (rst < 0)
+        {
+            return(rst);
+        }
+        p += modbus_cvt_u16_put(p, val);
+    }
+    return(0);
+}
+
+
+/**
+ * @brief  将大端序数据写入连续保持寄存器
+ *
+ * 注册了 write_hold_range 时先整块转换到 hinst->datas 再调用一次，
+ * 否则逐个调用 write_hold。
+ *
+ * @param[in] hinst  从站实例
+ * @param[in] addr   起始地址
+ * @param[in] nb     寄存器数量
+ * @param[in] pdata  写入数据（大端序）
+ *
+ * @return int  0-成功, <0-异常码取负（两种回调都未注册时返回从站设备故障）
+ */
+static int modbus_slave_regs_write(mb_inst_t *hinst, uint16_t addr, int nb, const uint8_t *pdata)
+{
+    if (hinst->cb->write_hold_range != NULL)
+    {
+        uint16_t *pregs = (uint16_t *)hinst->datas;
+        modbus_cvt_u16_get_block(pdata, pregs, nb);
+        return(hinst->cb->write_hold_range(addr, nb, pregs));
+    }
+
+    if (hinst->cb->write_hold == NULL)
+    {
+        return(-MODBUS_EC_SLAVE_OR_SERVER_FAILURE);
+    }
+
+    const uint8_t *p = pdata;
+    for (int i=0; i<nb; i++)
+    {
+        uint16_t val;
+        p += modbus_cvt_u16_get(p, &val);
+        int rst = hinst->cb->write_hold(addr + i, val);
+        if (rst < 0)
+        {
+            return(rst);
+        }
+    }
+    return(0);
+}
+
+
 /**
  * @brief  处理 Modbus 从站读保持寄存器请求（功能码 0x03）
  *
@@ -205,22 +308,22 @@ static void modbus_slave_pdu_deal_read_discs(mb_inst_t *hinst, mb_pdu_t *pdu)
  *   - 失败：设置 pdu->exc.ec 和 pdu->exc.fc，触发异常响应
  *
  * @note
- *   - 依赖用户注册的回调函数 hinst->cb->read_hold(addr, &val)
+ *   - 优先使用批量回调 hinst->cb->read_hold_range(addr, nb, pregs)，
+ *     未注册时逐个调用 hinst->cb->read_hold(addr, &val)
  *   - 每个寄存器占 2 字节，大端序（高字节在前，低字节在后），符合 Modbus 协议
- *   - 响应数据使用 hinst->datas 作为临时缓冲区
+ *   - 寄存器值直接按大端序写入发送缓冲区的响应数据区，封帧时无需拷贝
  *   - 总字节数 = nb × 2
  *   - 上层调用 modbus_rtu_frame_make() 会自动添加地址字段和 CRC
  *
  * @warning
- *   - 若未注册 read_hold 回调，返回异常码 0x04（从站设备故障）
+ *   - 若 read_hold_range 和 read_hold 均未注册，返回异常码 0x04（从站设备故障）
  *   - 用户回调返回负值时，自动转换为 Modbus 标准异常码（如 -2 → 0x02）
- *   - hinst->datas 必须足够大（至少 256 字节），否则可能溢出
  *   - 保持寄存器地址空间独立于输入寄存器（0x04）
  */
 static void modbus_slave_pdu_deal_read_holds(mb_inst_t *hinst, mb_pdu_t *pdu)
 {
-    /* 1. 检查是否注册了读保持寄存器回调函数 */
-    if ((hinst->cb == NULL) || (hinst->cb->read_hold == NULL))
+    /* 1. 检查是否注册了回调函数表 */
+    if (hinst->cb == NULL)
     {
         /* 未实现读保持寄存器功能 → 返回异常响应 0x04（从站设备故障） */
         pdu->exc.ec = MODBUS_EC_SLAVE_OR_SERVER_FAILURE;
@@ -231,26 +334,19 @@ static void modbus_slave_pdu_deal_read_holds(mb_inst_t *hinst, mb_pdu_t *pdu)
     /* 2. 提取请求参数 */
     uint16_t addr = pdu->rd_req.addr;
     int nb = pdu->rd_req.nb;
-    /* 3. 初始化数据指针，指向从站通用缓冲区 */
-    uint8_t *p = hinst->datas;
-    /* 4. 遍历每个寄存器，调用用户回调获取值并写入缓冲区（大端序） */
-    for (int i=0; i<nb; i++)
+    /* 3. 读取寄存器直接到响应数据区（大端序），优先使用批量回调 */
+    uint8_t *pdata = modbus_slave_rsp_data(hinst);
+    int rst = modbus_slave_regs_read(hinst, hinst->cb->read_hold_range, hinst->cb->read_hold, addr, nb, pdata);
+    if (rst < 0)
     {
-        uint16_t val;
-        int rst = hinst->cb->read_hold(addr + i, &val);
-        if (rst < 0)
-        {
-            pdu->exc.ec = -rst;
-            pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
-            return;
-        }
-        /* 将 16 位值以大端序写入缓冲区：高字节在前 */
-        p += modbus_cvt_u16_put(p, val);
+        pdu->exc.ec = -rst;
+        pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
+        return;
     }
 
     /* 5. 构造响应字段 */
     pdu->rd_rsp.dlen = 2 * nb;          // 总字节数 = 寄存器数 × 2
-    pdu->rd_rsp.pdata = hinst->datas;   // 指向寄存器数据首地址
+    pdu->rd_rsp.pdata = pdata;          // 指向寄存器数据首地址
 
     /* 响应格式示例（nb=2, 值=0x1234, 0x5678）
      *   [FC=0x03][字节计数=4][12 34 56 78]
@@ -259,7 +355,7 @@ static void modbus_slave_pdu_deal_read_holds(mb_inst_t *hinst, mb_pdu_t *pdu)
 
 static void modbus_slave_pdu_deal_read_inputs(mb_inst_t *hinst, mb_pdu_t *pdu)
 {
-    if ((hinst->cb == NULL) || (hinst->cb->read_input == NULL))
+    if (hinst->cb == NULL)
     {
         pdu->exc.ec = MODBUS_EC_SLAVE_OR_SERVER_FAILURE;
         pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
@@ -268,22 +364,17 @@ static void modbus_slave_pdu_deal_read_inputs(mb_inst_t *hinst, mb_pdu_t *pdu)
 
     uint16_t addr = pdu->rd_req.addr;
     int nb = pdu->rd_req.nb;
-    uint8_t *p = hinst->datas;
-    for (int i=0; i<nb; i++)
+    uint8_t *pdata = modbus_slave_rsp_data(hinst);
+    int rst = modbus_slave_regs_read(hinst, hinst->cb->read_input_range, hinst->cb->read_input, addr, nb, pdata);
+    if (rst < 0)
     {
-        uint16_t val;
-        int rst = hinst->cb->read_input(addr + i, &val);
-        if (rst < 0)
-        {
-            pdu->exc.ec = -rst;
-            pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
-            return;
-        }
-        p += modbus_cvt_u16_put(p, val);
+        pdu->exc.ec = -rst;
+        pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
+        return;
     }
 
     pdu->rd_rsp.dlen = 2 * nb;
-    pdu->rd_rsp.pdata = hinst->datas;
+    pdu->rd_rsp.pdata = pdata;
 }
 
 
@@ -371,7 +462,7 @@ static void modbus_slave_pdu_deal_write_coil(mb_inst_t *hinst, mb_pdu_t *pdu)
  *   - 失败：设置 pdu->exc.ec 和 pdu->exc.fc，触发异常响应
  *
  * @note
- *   - 依赖用户注册的回调函数 hinst->cb->write_hold(addr, val)
+ *   - 依赖用户注册的回调函数 hinst->cb->write_hold(addr, val)，未注册时使用 write_hold_range
  *   - 写入值 `val` 为 16 位无符号整数（0 ~ 65535），大端序传输
  *   - 成功响应格式与请求完全相同（回显）
  *   - 上层调用 modbus_rtu_frame_make() 会自动添加地址字段和 CRC
@@ -386,7 +477,7 @@ static void modbus_slave_pdu_deal_write_coil(mb_inst_t *hinst, mb_pdu_t *pdu)
 static void modbus_slave_pdu_deal_write_reg(mb_inst_t *hinst, mb_pdu_t *pdu)
 {
     /* 1. 检查是否注册了写保持寄存器回调函数 */
-    if ((hinst->cb == NULL) || (hinst->cb->write_hold == NULL))
+    if ((hinst->cb == NULL) || ((hinst->cb->write_hold == NULL) && (hinst->cb->write_hold_range == NULL)))
     {
         pdu->exc.ec = MODBUS_EC_SLAVE_OR_SERVER_FAILURE;
         pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
@@ -396,8 +487,8 @@ static void modbus_slave_pdu_deal_write_reg(mb_inst_t *hinst, mb_pdu_t *pdu)
     /* 2. 提取请求参数 */
     uint16_t addr = pdu->wr_single.addr;    // 目标保持寄存器地址
     uint16_t val = pdu->wr_single.val;      // 写入值（16 位，大端序）
-    /* 3. 调用用户回调执行实际写入操作 */
-    int rst = hinst->cb->write_hold(addr, val);
+    /* 3. 调用用户回调执行实际写入操作, 仅注册批量回调时按 1 个寄存器调用 */
+    int rst = (hinst->cb->write_hold != NULL) ? hinst->cb->write_hold(addr, val) : hinst->cb->write_hold_range(addr, 1, &val);
     /* 4. 用户回调失败 → 转换为 Modbus 异常响应 */
     if (rst < 0)
     {
@@ -488,21 +579,22 @@ static void modbus_slave_pdu_deal_write_coils(mb_inst_t *hinst, mb_pdu_t *pdu)
  *   - 失败：设置 pdu->exc.ec 和 pdu->exc.fc，触发异常响应
  *
  * @note
- *   - 依赖用户注册的回调函数 hinst->cb->write_hold(addr, val)
+ *   - 优先使用批量回调 hinst->cb->write_hold_range(addr, nb, pregs)，
+ *     未注册时逐个调用 hinst->cb->write_hold(addr, val)
  *   - 寄存器数据采用 **大端字节序**（高字节在前），由 modbus_cvt_u16_get() 解析
  *   - 总字节数 = nb × 2，必须与 pdu->wr_req.dlen 一致（由上层验证）
  *   - 成功响应格式：`[FC][地址H][地址L][数量H][数量L]`
  *   - 上层调用 modbus_rtu_frame_make() 会自动添加地址字段和 CRC
  *
  * @warning
- *   - 若未注册 write_hold 回调，返回异常码 0x04（从站设备故障）
+ *   - 若 write_hold_range 和 write_hold 均未注册，返回异常码 0x04（从站设备故障）
  *   - 用户回调返回负值时，自动转换为 Modbus 标准异常码（如 -2 → 0x02）
- *   - 不使用 hinst->datas 缓冲区（请求数据直接来自 pdu->wr_req.pdata）
+ *   - 使用批量回调时 hinst->datas 作为主机序寄存器数组
  *   - 必须确保 pdu->wr_req.pdata 指向有效数据流且长度正确（由上层保证）
  */
 static void modbus_slave_pdu_deal_write_regs(mb_inst_t *hinst, mb_pdu_t *pdu)
 {
-    if ((hinst->cb == NULL) || (hinst->cb->write_hold == NULL))
+    if (hinst->cb == NULL)
     {
         pdu->exc.ec = MODBUS_EC_SLAVE_OR_SERVER_FAILURE;
         pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
@@ -511,18 +603,12 @@ static void modbus_slave_pdu_deal_write_regs(mb_inst_t *hinst, mb_pdu_t *pdu)
 
     uint16_t addr = pdu->wr_req.addr;
     int nb = pdu->wr_req.nb;
-    uint8_t *p = pdu->wr_req.pdata;
-    for (int i=0; i<nb; i++)
+    int rst = modbus_slave_regs_write(hinst, addr, nb, pdu->wr_req.pdata);
+    if (rst < 0)
     {
-        uint16_t val;
-        p += modbus_cvt_u16_get(p, &val);
-        int rst = hinst->cb->write_hold(addr + i, val);
-        if (rst < 0)
-        {
-            pdu->exc.ec = -rst;
-            pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
-            return;
-        }
+        pdu->exc.ec = -rst;
+        pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
+        return;
     }
 }
 
@@ -559,14 +645,14 @@ static void modbus_slave_pdu_deal_write_regs(mb_inst_t *hinst, mb_pdu_t *pdu)
  *   - 上层调用 modbus_rtu_frame_make() 会自动添加地址字段和 CRC
  *
  * @warning
- *   - 若未注册 read_hold 或 write_hold 回调，返回异常码 0x04（从站设备故障）
+ *   - 读、写各自的单寄存器和批量回调都未注册时，返回异常码 0x04（从站设备故障）
  *   - 用户回调返回负值时，自动转换为 Modbus 标准异常码（如 -2 → 0x02）
- *   - 不使用 hinst->datas 缓冲区（响应直接回显请求）
+ *   - 响应直接回显请求
  *   - 保持寄存器地址空间独立于输入寄存器
  */
 static void modbus_slave_pdu_deal_mask_write_reg(mb_inst_t *hinst, mb_pdu_t *pdu)
 {
-    if ((hinst->cb == NULL) || (hinst->cb->read_hold == NULL) || (hinst->cb->write_hold == NULL))
+    if (hinst->cb == NULL)
     {
         pdu->exc.ec = MODBUS_EC_SLAVE_OR_SERVER_FAILURE;
         pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
@@ -577,15 +663,18 @@ static void modbus_slave_pdu_deal_mask_write_reg(mb_inst_t *hinst, mb_pdu_t *pdu
     uint16_t val_and = pdu->mask_wr.val_and;
     uint16_t val_or = pdu->mask_wr.val_or;
     uint16_t val;
-    int rst = hinst->cb->read_hold(addr, &val);
+    uint16_t tmp;//大端序暂存
+    int rst = modbus_slave_regs_read(hinst, hinst->cb->read_hold_range, hinst->cb->read_hold, addr, 1, (uint8_t *)&tmp);
     if (rst < 0)
     {
         pdu->exc.ec = -rst;
         pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
         return;
     }
+    modbus_cvt_u16_get((uint8_t *)&tmp, &val);
     val = ((val & val_and) | (val_or & ~val_and));
-    rst = hinst->cb->write_hold(addr, val);
+    modbus_cvt_u16_put((uint8_t *)&tmp, val);
+    rst = modbus_slave_regs_write(hinst, addr, 1, (uint8_t *)&tmp);
     if (rst < 0)
     {
         pdu->exc.ec = -rst;
@@ -617,11 +706,11 @@ static void modbus_slave_pdu_deal_mask_write_reg(mb_inst_t *hinst, mb_pdu_t *pdu
  *   - 失败：设置 pdu->exc.ec 和 pdu->exc.fc，触发异常响应
  *
  * @note
- *   - 依赖用户注册的回调函数：
- *       - hinst->cb->write_hold(addr, val)  // 写操作
- *       - hinst->cb->read_hold(addr, &val)  // 读操作
+ *   - 依赖用户注册的回调函数（批量回调优先）：
+ *       - hinst->cb->write_hold_range / write_hold  // 写操作
+ *       - hinst->cb->read_hold_range / read_hold    // 读操作
  *   - 写数据：从 pdu->wr_rd_req.pdata 解析，大端序
- *   - 读数据：写入 hinst->datas 缓冲区，大端序
+ *   - 读数据：直接写入发送缓冲区的响应数据区，大端序
  *   - 响应格式：`[FC][字节计数][读出数据流]`，**不包含写相关信息**
  *   - 上层调用 modbus_rtu_frame_make() 会自动添加地址字段和 CRC
  *
@@ -629,12 +718,12 @@ static void modbus_slave_pdu_deal_mask_write_reg(mb_inst_t *hinst, mb_pdu_t *pdu
  *   - 若未注册 read_hold 或 write_hold 回调，返回异常码 0x04（从站设备故障）
  *   - 用户回调返回负值时，自动转换为 Modbus 标准异常码（如 -2 → 0x02）
  *   - 写操作失败时 **立即中止**，不执行读操作
- *   - hinst->datas 必须足够大（至少 252 字节），支持最大 125 个寄存器
+ *   - 响应数据区与请求中的写数据重叠，必须先完成写操作再读
  *   - 读写地址可相同或不同，协议允许重叠
  */
 static void modbus_slave_pdu_deal_write_and_read_regs(mb_inst_t *hinst, mb_pdu_t *pdu)
 {
-    if ((hinst->cb == NULL) || (hinst->cb->read_hold == NULL) || (hinst->cb->write_hold == NULL))
+    if (hinst->cb == NULL)
     {
         pdu->exc.ec = MODBUS_EC_SLAVE_OR_SERVER_FAILURE;
         pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
@@ -645,40 +734,154 @@ static void modbus_slave_pdu_deal_write_and_read_regs(mb_inst_t *hinst, mb_pdu_t
     int rd_nb = pdu->wr_rd_req.rd_nb;
     uint16_t wr_addr = pdu->wr_rd_req.wr_addr;
     int wr_nb = pdu->wr_rd_req.wr_nb;
-    uint8_t *p = pdu->wr_rd_req.pdata;
-    for (int i=0; i<wr_nb; i++)
+    int rst = modbus_slave_regs_write(hinst, wr_addr, wr_nb, pdu->wr_rd_req.pdata);
+    if (rst < 0)
     {
+        pdu->exc.ec = -rst;
+        pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
+        return;
+    }
+
+    uint8_t *pdata = modbus_slave_rsp_data(hinst);
+    rst = modbus_slave_regs_read(hinst, hinst->cb->read_hold_range, hinst->cb->read_hold, rd_addr, rd_nb, pdata);
+    if (rst < 0)
+    {
+        pdu->exc.ec = -rst;
+        pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
+        return;
+    }
+
+    pdu->rd_rsp.dlen = rd_nb * 2;
+    pdu->rd_rsp.pdata = pdata;
+}
+
+#ifdef MB_USING_REGBANK
+/**
+ * @brief  按寄存器库处理 Modbus 从站请求
+ *
+ * 请求直接在声明的存储区上完成：二分查找所在区，读操作整块转换为
+ * 大端序，写操作经写入钩子检查后整块写入，不经过回调函数表。
+ *
+ * @param[in,out] hinst  Modbus 从站实例指针（hinst->bank 非 NULL）
+ * @param[in,out] pdu    PDU 结构体指针，输入为请求，输出为响应或异常
+ *
+ * @note
+ *   - 请求须完整落在一个区内，否则以异常码 0x02（非法数据地址）应答
+ *   - 写单个线圈的值须为 0xFF00 或 0x0000，否则以异常码 0x03 应答
+ *   - 读出数据直接写入发送缓冲区的响应数据区，封帧时无需拷贝
+ */
+static void modbus_slave_pdu_deal_bank(mb_inst_t *hinst, mb_pdu_t *pdu)
+{
+    const mb_regbank_t *bank = hinst->bank;
+    uint8_t *pdata = modbus_slave_rsp_data(hinst);
+    int rst = 0;
+
+    switch(pdu->fc)
+    {
+    case MODBUS_FC_READ_COILS :
+    case MODBUS_FC_READ_DISCRETE_INPUTS :
+    {
+        mb_reg_type_t type = (pdu->fc == MODBUS_FC_READ_COILS) ? MB_REG_TYPE_COIL : MB_REG_TYPE_DISC;
+        int nb = pdu->rd_req.nb;
+        rst = modbus_regbank_read(bank, type, pdu->rd_req.addr, nb, pdata);
+        if (rst == 0)
+        {
+            pdu->rd_rsp.dlen = (nb + 7) / 8;
+            pdu->rd_rsp.pdata = pdata;
+        }
+        break;
+    }
+    case MODBUS_FC_READ_HOLDING_REGISTERS :
+    case MODBUS_FC_READ_INPUT_REGISTERS :
+    {
+        mb_reg_type_t type = (pdu->fc == MODBUS_FC_READ_HOLDING_REGISTERS) ? MB_REG_TYPE_HOLD : MB_REG_TYPE_INPUT;
+        int nb = pdu->rd_req.nb;
+        rst = modbus_regbank_read(bank, type, pdu->rd_req.addr, nb, pdata);
+        if (rst == 0)
+        {
+            pdu->rd_rsp.dlen = nb * 2;
+            pdu->rd_rsp.pdata = pdata;
+        }
+        break;
+    }
+    case MODBUS_FC_WRITE_SINGLE_COIL :
+    {
+        if ((pdu->wr_single.val != 0xFF00) && (pdu->wr_single.val != 0x0000))
+        {
+            rst = -MODBUS_EC_ILLEGAL_DATA_VALUE;
+            break;
+        }
+        uint8_t bit = (pdu->wr_single.val ? 1 : 0);
+        rst = modbus_regbank_write(bank, MB_REG_TYPE_COIL, pdu->wr_single.addr, 1, &bit);
+        break;
+    }
+    case MODBUS_FC_WRITE_SINGLE_REGISTER :
+    {
+        uint8_t tmp[2];
+        modbus_cvt_u16_put(tmp, pdu->wr_single.val);
+        rst = modbus_regbank_write(bank, MB_REG_TYPE_HOLD, pdu->wr_single.addr, 1, tmp);
+        break;
+    }
+    case MODBUS_FC_WRITE_MULTIPLE_COILS :
+        rst = modbus_regbank_write(bank, MB_REG_TYPE_COIL, pdu->wr_req.addr, pdu->wr_req.nb, pdu->wr_req.pdata);
+        break;
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
+        rst = modbus_regbank_write(bank, MB_REG_TYPE_HOLD, pdu->wr_req.addr, pdu->wr_req.nb, pdu->wr_req.pdata);
+        break;
+    case MODBUS_FC_MASK_WRITE_REGISTER :
+    {
+        uint8_t tmp[2];
         uint16_t val;
-        p += modbus_cvt_u16_get(p, &val);
-        int rst = hinst->cb->write_hold(wr_addr + i, val);
+        rst = modbus_regbank_read(bank, MB_REG_TYPE_HOLD, pdu->mask_wr.addr, 1, tmp);
         if (rst < 0)
         {
-            pdu->exc.ec = -rst;
-            pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
-            return;
+            break;
         }
+        modbus_cvt_u16_get(tmp, &val);
+        val = ((val & pdu->mask_wr.val_and) | (pdu->mask_wr.val_or & ~pdu->mask_wr.val_and));
+        modbus_cvt_u16_put(tmp, val);
+        rst = modbus_regbank_write(bank, MB_REG_TYPE_HOLD, pdu->mask_wr.addr, 1, tmp);
+        break;
     }
-
-    p = hinst->datas;
-    for (int i=0; i<rd_nb; i++)
+    case MODBUS_FC_WRITE_AND_READ_REGISTERS :
     {
-        uint16_t val;
-        int rst = hinst->cb->read_hold(rd_addr + i, &val);
+        uint16_t rd_addr = pdu->wr_rd_req.rd_addr;
+        int rd_nb = pdu->wr_rd_req.rd_nb;
+        rst = modbus_regbank_write(bank, MB_REG_TYPE_HOLD, pdu->wr_rd_req.wr_addr, pdu->wr_rd_req.wr_nb, pdu->wr_rd_req.pdata);
         if (rst < 0)
         {
-            pdu->exc.ec = -rst;
-            pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
-            return;
+            break;
         }
-        p += modbus_cvt_u16_put(p, val);
+        rst = modbus_regbank_read(bank, MB_REG_TYPE_HOLD, rd_addr, rd_nb, pdata);//写操作已完成, 可覆盖请求数据
+        if (rst == 0)
+        {
+            pdu->rd_rsp.dlen = rd_nb * 2;
+            pdu->rd_rsp.pdata = pdata;
+        }
+        break;
+    }
+    default:
+        break;
     }
 
-    pdu->rd_rsp.dlen = rd_nb * 2;
-    pdu->rd_rsp.pdata = hinst->datas;
+    if (rst < 0)
+    {
+        pdu->exc.ec = -rst;
+        pdu->exc.fc = MODBUS_FC_EXCEPT_MAKE(pdu->exc.fc);
+    }
 }
+#endif
 
 static void modbus_slave_pdu_deal(mb_inst_t *hinst, mb_pdu_t *pdu)
 {
+    #ifdef MB_USING_REGBANK
+    if (hinst->bank != NULL)//使用寄存器库, 不经过回调函数表
+    {
+        modbus_slave_pdu_deal_bank(hinst, pdu);
+        return;
+    }
+    #endif
+
     switch(pdu->fc)
     {
     case MODBUS_FC_READ_COILS :
@@ -724,7 +927,7 @@ static void modbus_slave_pdu_deal(mb_inst_t *hinst, mb_pdu_t *pdu)
 static void modbus_slave_recv_deal_rtu(mb_inst_t *hinst, uint8_t *buf, int len)
 {
     mb_rtu_frm_t frm;
-    int pdu_len = modbus_rtu_frame_parse(buf, len, &frm, MB_PDU_TYPE_REQ);
+    int pdu_len = modbus_rtu_frame_parse_crc(buf, len, &frm, MB_PDU_TYPE_REQ, modbus_rx_crc(hinst));
     if (pdu_len == 0)//帧错误, 不处理
     {
         return;
@@ -737,9 +940,11 @@ static void modbus_slave_recv_deal_rtu(mb_inst_t *hinst, uint8_t *buf, int len)
     }
     #endif
 
-    if (pdu_len < 0)//功能码不支持, 响应异常帧
+    //功能码不支持或请求不合法, 不调用回调直接响应异常帧
+    int ec = (pdu_len < 0) ? MODBUS_EC_ILLEGAL_FUNCTION : modbus_pdu_check(&(frm.pdu));
+    if (ec != 0)
     {
-        frm.pdu.exc.ec = MODBUS_EC_ILLEGAL_FUNCTION;
+        frm.pdu.exc.ec = ec;
         frm.pdu.exc.fc = MODBUS_FC_EXCEPT_MAKE(frm.pdu.exc.fc);
     }
     else
@@ -776,9 +981,11 @@ static void modbus_slave_recv_deal_tcp(mb_inst_t *hinst, uint8_t *buf, int len)
     }
     #endif
 
-    if (pdu_len < 0)//功能码不支持, 响应异常帧
+    //功能码不支持或请求不合法, 不调用回调直接响应异常帧
+    int ec = (pdu_len < 0) ? MODBUS_EC_ILLEGAL_FUNCTION : modbus_pdu_check(&(frm.pdu));
+    if (ec != 0)
     {
-        frm.pdu.exc.ec = MODBUS_EC_ILLEGAL_FUNCTION;
+        frm.pdu.exc.ec = ec;
         frm.pdu.exc.fc = MODBUS_FC_EXCEPT_MAKE(frm.pdu.exc.fc);
     }
     else
@@ -817,6 +1024,9 @@ const mb_cb_table_t mb_cb_table = {
     .read_input = modbus_port_read_input,    //读输入寄存器
     .read_hold = modbus_port_read_hold,      //读保持寄存器
     .write_hold = modbus_port_write_hold,    //写保持寄存器
+    .read_input_range = NULL,               //批量读输入寄存器, 未使用
+    .read_hold_range = NULL,                //批量读保持寄存器, 未使用
+    .write_hold_range = NULL,               //批量写保持寄存器, 未使用
 };
 
 //修改从机回调函数表, 默认使用modbus_port中接口函数做回调函数
@@ -828,6 +1038,16 @@ void modbus_set_cb_table(mb_inst_t *hinst, const mb_cb_table_t *cb)
     hinst->cb = (mb_cb_table_t *)cb;
 }
 
+#ifdef MB_USING_REGBANK
+//设置寄存器库, 设置后从机直接按区表应答请求, 不再调用回调函数表, NULL恢复使用回调函数表
+void modbus_set_regbank(mb_inst_t *hinst, const mb_regbank_t *bank)
+{
+    MB_ASSERT(hinst != NULL);
+
+    hinst->bank = bank;
+}
+#endif
+
 //从机状态机处理, 在线程中循环调用即可
 void modbus_slave_fsm(mb_inst_t *hinst)
 {
@@ -839,7 +1059,7 @@ void modbus_slave_fsm(mb_inst_t *hinst)
         return;
     }
 
-    int rlen = modbus_recv(hinst, hinst->buf, sizeof(hinst->buf));
+    int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_REQ);
     if (rlen <= 0)
     {
         return;
@@ -848,6 +1068,51 @@ void modbus_slave_fsm(mb_inst_t *hinst)
     modbus_slave_recv_deal(hinst, hinst->buf, rlen);
 }
 
+
+/**
+ * @brief  处理已到达的请求
+ *
+ * 供多路复用的服务器在连接可读时调用：接收并应答一个请求，
+ * 客户端连续发送的多个请求已在重组缓冲区中时一并处理。
+ * 实例应答超时设为 0 时不等待首字节，未收完的半帧留待下次可读时继续。
+ *
+ * @param[in,out] hinst  Modbus 实例指针（通常为 SOCK 后端）
+ *
+ * @return int
+ *   - >=0 : 处理的请求数
+ *   -  -1 : 连接已断开（后端已关闭）
+ */
+int modbus_slave_poll(mb_inst_t *hinst)
+{
+    MB_ASSERT(hinst != NULL);
+
+    if (modbus_connect(hinst) < 0)//连接已断开
+    {
+        return(-1);
+    }
+
+    int cnt = 0;
+    do{
+        int rlen = modbus_recv_frame(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_REQ);
+        if (rlen < 0)
+        {
+            return(-1);
+        }
+        if (rlen == 0)
+        {
+            break;
+        }
+        modbus_slave_recv_deal(hinst, hinst->buf, rlen);
+        cnt++;
+        if (hinst->backend->hinst == NULL)//应答发送失败, 后端已关闭
+        {
+            return(-1);
+        }
+    }while(hinst->backend->rsv_len > 0);
+
+    return(cnt);
+}
+
 #endif
 
 
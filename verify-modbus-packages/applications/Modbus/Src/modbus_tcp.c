@@ -36,12 +36,29 @@
 int modbus_tcp_frm_make(uint8_t *buf, const mb_tcp_frm_t *frm, mb_pdu_type_t type)//生成tcp帧, 返回帧长度
 {
     int pdu_len = modbus_pdu_make(buf + MB_TCP_MBAP_SIZE, &(frm->pdu), type);
+    return(modbus_tcp_frm_seal(buf, &(frm->mbap), pdu_len));
+}
+
 
+/**
+ * @brief  封装已写入缓冲区的 PDU 为 TCP 帧
+ *
+ * 零拷贝编码：调用者直接在 buf + MB_TCP_MBAP_SIZE 处写入 PDU，
+ * 本函数在预留的位置填写 MBAP 头（长度字段自动计算）。
+ *
+ * @param[in,out] buf      帧缓冲区（PDU 已写入 buf + MB_TCP_MBAP_SIZE 处）
+ * @param[in]     mbap     MBAP 头（dlen 忽略）
+ * @param[in]     pdu_len  PDU 长度
+ *
+ * @return int  帧总长度（7 + PDU 长度）
+ */
+int modbus_tcp_frm_seal(uint8_t *buf, const mb_tcp_mbap_t *mbap, int pdu_len)
+{
     uint8_t *p = buf;
-    p += modbus_cvt_u16_put(p, frm->mbap.tid);
-    p += modbus_cvt_u16_put(p, frm->mbap.pid);
+    p += modbus_cvt_u16_put(p, mbap->tid);
+    p += modbus_cvt_u16_put(p, mbap->pid);
     p += modbus_cvt_u16_put(p, pdu_len + 1);
-    p += modbus_cvt_u8_put(p, frm->mbap.did);
+    p += modbus_cvt_u8_put(p, mbap->did);
     p += pdu_len;
 
     return((int)(p - buf));
@@ -68,6 +85,7 @@ int modbus_tcp_frm_make(uint8_t *buf, const mb_tcp_frm_t *frm, mb_pdu_type_t typ
  *
  * @note
  *   - 自动校验 MBAP 长度字段（dlen == pdu_len + 1）
+ *   - PDU 解析范围限定在 dlen 之内，缓冲区中多余的数据被忽略
  *   - 自动校验协议标识符（pid == 0x0000）
  *   - 调用 modbus_pdu_parse() 解析 PDU
  */
@@ -83,7 +101,14 @@ int modbus_tcp_frm_parse(const uint8_t *buf, int len, mb_tcp_frm_t *frm, mb_pdu_
     p += modbus_cvt_u16_get(p, &(frm->mbap.dlen));
     p += modbus_cvt_u8_get(p, &(frm->mbap.did));
 
-    int remain = len - (int)(p - buf);
+    if ((frm->mbap.dlen < (MB_PDU_SIZE_MIN + 1)) || (frm->mbap.dlen > (MB_PDU_SIZE_MAX + 1))){
+        return(0);
+    }
+    if ((len - (int)(p - buf)) < (frm->mbap.dlen - 1)){//数据不足dlen
+        return(0);
+    }
+
+    int remain = frm->mbap.dlen - 1;//pdu以MBAP长度字段为界, 不越界读取后续帧
     int pdu_len = modbus_pdu_parse(p, remain, &(frm->pdu), type);
     if (pdu_len <= 0){
         return(pdu_len);
@@ -96,6 +121,40 @@ int modbus_tcp_frm_parse(const uint8_t *buf, int len, mb_tcp_frm_t *frm, mb_pdu_
     return(pdu_len);
 }
 
+
+
+
+/**
+ * @brief  由 MBAP 头得出完整 Modbus TCP 帧长度
+ *
+ * TCP 是字节流，一次 recv 可能包含半帧或多帧。MBAP 的长度字段
+ * 给出其后的字节数（DID + PDU），据此可精确切分每一帧，无需超时断帧。
+ * 作为流式后端的帧长度预测函数使用。
+ *
+ * @param[in] buf   已接收的数据（从 MBAP 头开始）
+ * @param[in] len   已接收长度
+ * @param[in] type  未使用（请求和响应规则相同）
+ *
+ * @return int
+ *   - >0 : 完整帧长度（6 + dlen）
+ *   -  0 : 数据不足 6 字节
+ *   - -1 : 长度字段非法（流已失步）
+ */
+int modbus_tcp_frm_len(const uint8_t *buf, int len, int type)
+{
+    (void)type;
+    if (len < (MB_TCP_MBAP_SIZE - 1)){
+        return(0);
+    }
+
+    int dlen = ((int)buf[4] << 8) | buf[5];
+    if ((dlen < (MB_PDU_SIZE_MIN + 1)) || (dlen > (MB_PDU_SIZE_MAX + 1))){
+        return(-1);
+    }
+
+    return(MB_TCP_MBAP_SIZE - 1 + dlen);
+}
+
 #endif
 
 
@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+
+#include "bsp_sys.h"
+
+#if (defined(MB_USING_TCP_PIPELINE) && defined(MB_USING_MASTER) && defined(MB_USING_TCP_PROTOCOL))
+
+
+/**
+ * @brief  完成一个在途事务：释放槽位并回调
+ *
+ * 先释放槽位再回调，回调中可以直接提交新的请求。
+ */
+static void modbus_pipe_complete(mb_pipe_t *pipe, mb_pipe_slot_t *slot, int rst, const uint8_t *pdata, int dlen)
+{
+    modbus_pipe_cb_t cb = slot->cb;
+    void *arg = slot->arg;
+
+    slot->used = 0;
+    pipe->pending--;
+
+    if (cb != NULL)
+    {
+        cb(arg, rst, pdata, dlen);
+    }
+}
+
+
+/**
+ * @brief  以超时结果完成所有已超过应答超时的事务
+ *
+ * @return int  本次完成的事务数
+ */
+static int modbus_pipe_expire(mb_pipe_t *pipe)
+{
+    int done = 0;
+    long long now = modbus_port_get_ms();
+    int ack_tmo_ms = pipe->hinst->backend->ack_tmo_ms;
+
+    for (int i=0; i<pipe->win; i++)
+    {
+        mb_pipe_slot_t *slot = &(pipe->slot[i]);
+        if (slot->used && ((now - slot->tx_ms) > ack_tmo_ms))
+        {
+            modbus_pipe_complete(pipe, slot, 0, NULL, 0);
+            done++;
+        }
+    }
+
+    return(done);
+}
+
+
+/**
+ * @brief  以失败结果完成全部在途事务（连接断开、销毁）
+ *
+ * @return int  本次完成的事务数
+ */
+static int modbus_pipe_fail_all(mb_pipe_t *pipe)
+{
+    int done = 0;
+    for (int i=0; i<pipe->win; i++)
+    {
+        mb_pipe_slot_t *slot = &(pipe->slot[i]);
+        if (slot->used)
+        {
+            modbus_pipe_complete(pipe, slot, 0, NULL, 0);
+            done++;
+        }
+    }
+    return(done);
+}
+
+
+/**
+ * @brief  分发一帧响应到对应事务
+ *
+ * 按 MBAP 事务标识匹配在途事务，响应可以乱序到达。
+ * 找不到对应事务（已超时完成的迟到响应）时直接丢弃。
+ *
+ * @return int  完成的事务数（0 或 1），帧格式错误返回 -1
+ */
+static int modbus_pipe_dispatch(mb_pipe_t *pipe, int rlen)
+{
+    mb_inst_t *hinst = pipe->hinst;
+    mb_tcp_frm_t frm;
+
+    // 1. 解析响应帧
+    int pdu_len = modbus_tcp_frm_parse(hinst->buf, rlen, &frm, MB_PDU_TYPE_RSP);
+    if (pdu_len == 0)//帧格式错误
+    {
+        return(-1);
+    }
+
+    // 2. 按事务标识查找在途事务
+    mb_pipe_slot_t *slot = NULL;
+    for (int i=0; i<pipe->win; i++)
+    {
+        if (pipe->slot[i].used && (pipe->slot[i].tid == frm.mbap.tid))
+        {
+            slot = &(pipe->slot[i]);
+            break;
+        }
+    }
+    if (slot == NULL)//迟到或未知的响应
+    {
+        return(0);
+    }
+
+    // 3. 校验并生成结果, 与同步接口返回值一致
+    if ((pdu_len < 0) || (frm.mbap.pid != MB_TCP_MBAP_PID)
+        #ifdef MB_USING_ADDR_CHK
+        || (frm.mbap.did != hinst->saddr)
+        #endif
+        )
+    {
+        modbus_pipe_complete(pipe, slot, 0, NULL, 0);
+        return(1);
+    }
+
+    if (MODBUS_FC_EXCEPT_CHK(frm.pdu.fc))//是异常应答
+    {
+        modbus_pipe_complete(pipe, slot, -(int)frm.pdu.exc.ec, NULL, 0);
+        return(1);
+    }
+
+    if (frm.pdu.fc != slot->fc)//功能码与请求不符
+    {
+        modbus_pipe_complete(pipe, slot, 0, NULL, 0);
+        return(1);
+    }
+
+    switch(frm.pdu.fc)
+    {
+    case MODBUS_FC_READ_COILS :
+    case MODBUS_FC_READ_DISCRETE_INPUTS :
+    case MODBUS_FC_READ_HOLDING_REGISTERS :
+    case MODBUS_FC_READ_INPUT_REGISTERS :
+        if (frm.pdu.rd_rsp.dlen != modbus_pdu_data_len(slot->fc, slot->nb))//字节计数与请求数量不符
+        {
+            modbus_pipe_complete(pipe, slot, 0, NULL, 0);
+            break;
+        }
+        modbus_pipe_complete(pipe, slot, frm.pdu.rd_rsp.dlen, frm.pdu.rd_rsp.pdata, frm.pdu.rd_rsp.dlen);
+        break;
+    case MODBUS_FC_WRITE_MULTIPLE_COILS :
+    case MODBUS_FC_WRITE_MULTIPLE_REGISTERS :
+        modbus_pipe_complete(pipe, slot, frm.pdu.wr_rsp.nb, NULL, 0);
+        break;
+    default:
+        modbus_pipe_complete(pipe, slot, 1, NULL, 0);
+        break;
+    }
+
+    return(1);
+}
+
+
+/**
+ * @brief  创建 TCP 主机流水线
+ *
+ * 流水线允许在一个 TCP 连接上同时保持多个在途请求，
+ * 响应按 MBAP 事务标识匹配，可以乱序完成。
+ * 对前端挂多个 RTU 从机的 TCP 网关，吞吐量随窗口大小增长，
+ * 不再受限于每个往返只能完成一个请求。
+ *
+ * @param[in] hinst  Modbus 实例（须使用 MB_PROT_TCP 协议）
+ * @param[in] win    窗口大小（1 ~ MB_PIPE_WIN_MAX）
+ *
+ * @return mb_pipe_t*  成功返回流水线指针，失败返回 NULL
+ *
+ * @note
+ *   - 流水线使用实例的收发缓冲区，与同步接口不可在同一实例上混用
+ *   - 提交和接收须在同一线程中调用
+ *   - 连接由调用者通过 modbus_connect() 建立
+ */
+mb_pipe_t *modbus_pipe_create(mb_inst_t *hinst, int win)
+{
+    if ((hinst == NULL) || (hinst->prototype != MB_PROT_TCP))
+    {
+        return(NULL);
+    }
+    if ((win <= 0) || (win > MB_PIPE_WIN_MAX))
+    {
+        return(NULL);
+    }
+
+    mb_pipe_t *pipe = calloc(1, sizeof(mb_pipe_t));
+    if (pipe == NULL)
+    {
+        return(NULL);
+    }
+
+    pipe->hinst = hinst;
+    pipe->win = win;
+    pipe->pending = 0;
+
+    return(pipe);
+}
+
+
+/**
+ * @brief  销毁 TCP 主机流水线
+ *
+ * 未完成的事务以结果 0 回调后释放内存，不关闭连接。
+ *
+ * @param[in] pipe  流水线指针
+ */
+void modbus_pipe_destroy(mb_pipe_t *pipe)
+{
+    if (pipe == NULL)
+    {
+        return;
+    }
+
+    modbus_pipe_fail_all(pipe);
+    free(pipe);
+}
+
+
+/**
+ * @brief  提交一个请求
+ *
+ * 分配事务标识并发送请求帧，不等待响应。
+ * 窗口已满时先接收响应，直到有空闲槽位。
+ *
+ * @param[in] nb  请求数量（写单个为 1）
+ *
+ * @return int  成功返回事务标识，失败返回 -1（发送失败时全部在途事务以结果 0 完成）
+ */
+static int modbus_pipe_submit(mb_pipe_t *pipe, mb_tcp_frm_t *frm, int nb, modbus_pipe_cb_t cb, void *arg)
+{
+    mb_inst_t *hinst = pipe->hinst;
+
+    // 1. 窗口满时接收响应腾出空位
+    while(pipe->pending >= pipe->win)
+    {
+        if (modbus_pipe_poll(pipe, hinst->backend->ack_tmo_ms) < 0)
+        {
+            return(-1);
+        }
+    }
+
+    mb_pipe_slot_t *slot = NULL;
+    for (int i=0; i<pipe->win; i++)
+    {
+        if ( ! pipe->slot[i].used)
+        {
+            slot = &(pipe->slot[i]);
+            break;
+        }
+    }
+    if (slot == NULL)
+    {
+        return(-1);
+    }
+
+    // 2. 构建并发送请求帧
+    hinst->tsid++;
+    frm->mbap.tid = hinst->tsid;
+    frm->mbap.pid = MB_TCP_MBAP_PID;
+    frm->mbap.did = hinst->saddr;
+
+    int flen = modbus_tcp_frm_make(hinst->buf, frm, MB_PDU_TYPE_REQ);
+    int slen = modbus_send(hinst, hinst->buf, flen);
+    if (slen != flen)//连接已断开, 在途事务不会再有响应
+    {
+        modbus_pipe_fail_all(pipe);
+        return(-1);
+    }
+
+    // 3. 登记在途事务
+    slot->used = 1;
+    slot->fc = frm->pdu.fc;
+    slot->tid = frm->mbap.tid;
+    slot->nb = nb;
+    slot->tx_ms = modbus_port_get_ms();
+    slot->cb = cb;
+    slot->arg = arg;
+    pipe->pending++;
+
+    return(slot->tid);
+}
+
+
+/**
+ * @brief  提交读请求（功能码 0x01~0x04）
+ *
+ * @param[in] pipe  流水线指针
+ * @param[in] func  功能码
+ * @param[in] addr  起始地址
+ * @param[in] nb    数量（位或寄存器）
+ * @param[in] cb    完成回调，结果为读取的数据字节数
+ * @param[in] arg   回调参数
+ *
+ * @return int  成功返回事务标识，功能码非法或失败返回 -1
+ */
+int modbus_pipe_read_req(mb_pipe_t *pipe, uint8_t func, uint16_t addr, int nb, modbus_pipe_cb_t cb, void *arg)
+{
+    MB_ASSERT(pipe != NULL);
+    MB_ASSERT(nb > 0);
+
+    if ((func != MODBUS_FC_READ_COILS) && (func != MODBUS_FC_READ_DISCRETE_INPUTS)
+        && (func != MODBUS_FC_READ_HOLDING_REGISTERS) && (func != MODBUS_FC_READ_INPUT_REGISTERS))
+    {
+        return(-1);
+    }
+
+    mb_tcp_frm_t frm;
+    frm.pdu.rd_req.fc = func;
+    frm.pdu.rd_req.addr = addr;
+    frm.pdu.rd_req.nb = nb;
+
+    return(modbus_pipe_submit(pipe, &frm, nb, cb, arg));
+}
+
+
+/**
+ * @brief  提交写多个请求（功能码 0x0F / 0x10）
+ *
+ * @param[in] pipe   流水线指针
+ * @param[in] func   功能码
+ * @param[in] addr   起始地址
+ * @param[in] nb     数量（位或寄存器）
+ * @param[in] pdata  写入数据（大端字节流），提交后即可释放
+ * @param[in] dlen   数据字节数
+ * @param[in] cb     完成回调，结果为写入数量
+ * @param[in] arg    回调参数
+ *
+ * @return int  成功返回事务标识，功能码非法或失败返回 -1
+ */
+int modbus_pipe_write_req(mb_pipe_t *pipe, uint8_t func, uint16_t addr, int nb, const uint8_t *pdata, int dlen, modbus_pipe_cb_t cb, void *arg)
+{
+    MB_ASSERT(pipe != NULL);
+    MB_ASSERT(pdata != NULL);
+    MB_ASSERT(nb > 0);
+
+    if ((func != MODBUS_FC_WRITE_MULTIPLE_COILS) && (func != MODBUS_FC_WRITE_MULTIPLE_REGISTERS))
+    {
+        return(-1);
+    }
+
+    mb_tcp_frm_t frm;
+    frm.pdu.wr_req.fc = func;
+    frm.pdu.wr_req.addr = addr;
+    frm.pdu.wr_req.nb = nb;
+    frm.pdu.wr_req.dlen = dlen;
+    frm.pdu.wr_req.pdata = (uint8_t *)pdata;
+
+    return(modbus_pipe_submit(pipe, &frm, nb, cb, arg));
+}
+
+
+/**
+ * @brief  提交写单个请求（功能码 0x05 / 0x06）
+ *
+ * @param[in] pipe  流水线指针
+ * @param[in] func  功能码
+ * @param[in] addr  地址
+ * @param[in] val   写入值（线圈为 0xFF00 / 0x0000）
+ * @param[in] cb    完成回调，成功结果为 1
+ * @param[in] arg   回调参数
+ *
+ * @return int  成功返回事务标识，功能码非法或失败返回 -1
+ */
+int modbus_pipe_write_single(mb_pipe_t *pipe, uint8_t func, uint16_t addr, uint16_t val, modbus_pipe_cb_t cb, void *arg)
+{
+    MB_ASSERT(pipe != NULL);
+
+    if ((func != MODBUS_FC_WRITE_SINGLE_COIL) && (func != MODBUS_FC_WRITE_SINGLE_REGISTER))
+    {
+        return(-1);
+    }
+
+    mb_tcp_frm_t frm;
+    frm.pdu.wr_single.fc = func;
+    frm.pdu.wr_single.addr = addr;
+    frm.pdu.wr_single.val = val;
+
+    return(modbus_pipe_submit(pipe, &frm, 1, cb, arg));
+}
+
+
+/**
+ * @brief  接收并分发响应
+ *
+ * 等待时间不超过最早到期事务的剩余应答时间，超时事务以结果 0 完成。
+ * 已缓存在后端残留缓冲区中的后续响应一并处理。
+ *
+ * @param[in] pipe    流水线指针
+ * @param[in] tmo_ms  最长等待时间（毫秒）
+ *
+ * @return int
+ *   - >=0 : 本次完成的事务数
+ *   -  -1 : 连接错误（全部在途事务已以结果 0 完成）
+ */
+int modbus_pipe_poll(mb_pipe_t *pipe, int tmo_ms)
+{
+    MB_ASSERT(pipe != NULL);
+
+    mb_inst_t *hinst = pipe->hinst;
+    mb_backend_t *backend = hinst->backend;
+
+    // 1. 先完成已超时的事务
+    int done = modbus_pipe_expire(pipe);
+    if (pipe->pending == 0)
+    {
+        return(done);
+    }
+
+    // 2. 等待时间不超过最早到期事务的剩余时间
+    long long now = modbus_port_get_ms();
+    int wait_ms = tmo_ms;
+    for (int i=0; i<pipe->win; i++)
+    {
+        if (pipe->slot[i].used)
+        {
+            int remain = (int)(pipe->slot[i].tx_ms + backend->ack_tmo_ms - now);
+            if (remain < wait_ms)
+            {
+                wait_ms = remain;
+            }
+        }
+    }
+    if (wait_ms < 0)
+    {
+        wait_ms = 0;
+    }
+
+    // 3. 接收响应, 残留缓冲区中已有的完整帧连续处理
+    do{
+        int rlen = modbus_recv_frame_tmo(hinst, hinst->buf, sizeof(hinst->buf), MB_PDU_TYPE_RSP, wait_ms);
+        if (rlen < 0)//连接断开
+        {
+            modbus_pipe_fail_all(pipe);
+            return(-1);
+        }
+        if (rlen == 0)
+        {
+            break;
+        }
+        int rst = modbus_pipe_dispatch(pipe, rlen);
+        if (rst < 0)//流已失步, 丢弃缓存数据, 在途事务由超时完成
+        {
+            modbus_flush(hinst);
+            break;
+        }
+        done += rst;
+        wait_ms = 0;
+    }while(backend->rsv_len > 0);
+
+    // 4. 完成接收期间到期的事务
+    done += modbus_pipe_expire(pipe);
+
+    return(done);
+}
+
+
+/**
+ * @brief  等待全部在途事务完成
+ *
+ * @param[in] pipe  流水线指针
+ *
+ * @return int  完成的事务数，连接错误返回 -1
+ */
+int modbus_pipe_wait_all(mb_pipe_t *pipe)
+{
+    MB_ASSERT(pipe != NULL);
+
+    int done = 0;
+    while(pipe->pending > 0)
+    {
+        int rst = modbus_pipe_poll(pipe, pipe->hinst->backend->ack_tmo_ms);
+        if (rst < 0)
+        {
+            return(-1);
+        }
+        done += rst;
+    }
+
+    return(done);
+}
+
+#endif
@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2025-11-12     18452       the first version
+ */
+
+#include "bsp_sys.h"
+
+#if (defined(MB_USING_TCP_SERVER) && defined(MB_USING_SOCK_BACKEND) && defined(MB_USING_TCP_PROTOCOL) && defined(MB_USING_SLAVE))
+
+#include <sys/socket.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <sys/time.h>
+#ifdef RT_USING_POSIX_POLL
+#include <poll.h>
+#else
+#include <sys/ioctl.h>
+#endif
+
+#define DBG_TAG "mb.tcp.srv"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+
+/**
+ * @brief  创建监听 socket
+ *
+ * @return int  成功返回 0，失败返回 -1（网络未就绪等，下次处理时重试）
+ */
+static int modbus_tcp_srv_listen(mb_tcp_srv_t *srv)
+{
+    // 1. 创建 TCP socket
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0){
+        LOG_E("socket create fail.");
+        return(-1);
+    }
+
+    int opt = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // 2. 绑定端口
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(srv->port);
+    addr.sin_addr.s_addr = INADDR_ANY;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(struct sockaddr)) < 0){
+        closesocket(sock);
+        LOG_E("socket bind port %d fail.", srv->port);
+        return(-1);
+    }
+
+    // 3. 开始监听
+    if (listen(sock, srv->max_conn) < 0){
+        closesocket(sock);
+        LOG_E("socket listen fail.");
+        return(-1);
+    }
+
+    #ifndef RT_USING_POSIX_POLL
+    int nbio = 1;//无poll时轮询accept, 须为非阻塞
+    ioctlsocket(sock, FIONBIO, &nbio);
+    #endif
+
+    srv->lfd = sock;
+    LOG_I("listen on port %d, fd = %d.", srv->port, sock);
+    return(0);
+}
+
+
+/**
+ * @brief  接受一个新连接并分配实例
+ *
+ * 连接数已满时直接关闭新连接。
+ *
+ * @return int  成功返回 1，无新连接返回 0
+ */
+static int modbus_tcp_srv_accept(mb_tcp_srv_t *srv)
+{
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    int fd = accept(srv->lfd, (struct sockaddr *)&addr, &alen);
+    if (fd < 0){
+        return(0);
+    }
+
+    // 1. 查找空闲连接槽
+    int idx = -1;
+    for (int i=0; i<srv->max_conn; i++)
+    {
+        if (srv->conn[i] == NULL)
+        {
+            idx = i;
+            break;
+        }
+    }
+    if (idx < 0){
+        closesocket(fd);
+        LOG_W("connection full, reject fd = %d.", fd);
+        return(0);
+    }
+
+    // 2. 限制应答发送阻塞时间, 单个客户端不读取时不影响其它连接
+    struct timeval tv;
+    tv.tv_sec = MB_TCP_SRV_SND_TMO_MS / 1000;
+    tv.tv_usec = (MB_TCP_SRV_SND_TMO_MS % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    // 3. 以 SOCK 后端接管连接
+    mb_backend_param_t prm;
+    prm.sock.fd = fd;
+    mb_inst_t *hinst = modbus_create(MB_BACKEND_TYPE_SOCK, &prm);
+    if (hinst == NULL){
+        closesocket(fd);
+        LOG_E("modbus instance create fail.");
+        return(0);
+    }
+
+    modbus_set_slave_addr(hinst, srv->saddr);
+    if (srv->cb != NULL){
+        modbus_set_cb_table(hinst, srv->cb);
+    }
+    //仅在可读时处理, 不等待首字节; 半帧留在重组缓冲区等待下次可读
+    modbus_set_tmo(hinst, 0, hinst->backend->byte_tmo_ms);
+
+    srv->fd[idx] = fd;
+    srv->conn[idx] = hinst;
+    srv->conn_cnt++;
+    LOG_I("client %s connected, fd = %d, total %d.", inet_ntoa(addr.sin_addr), fd, srv->conn_cnt);
+
+    return(1);
+}
+
+
+/**
+ * @brief  释放一个连接（关闭 socket 并销毁实例）
+ */
+static void modbus_tcp_srv_release(mb_tcp_srv_t *srv, int idx)
+{
+    LOG_I("client fd = %d disconnected.", srv->fd[idx]);
+
+    modbus_destroy(srv->conn[idx]);
+    srv->conn[idx] = NULL;
+    srv->fd[idx] = -1;
+    srv->conn_cnt--;
+}
+
+
+/**
+ * @brief  处理一个连接上已到达的请求
+ *
+ * @return int  处理的请求数，连接断开时释放连接并返回 0
+ */
+static int modbus_tcp_srv_service(mb_tcp_srv_t *srv, int idx)
+{
+    int cnt = modbus_slave_poll(srv->conn[idx]);
+    if (cnt < 0)//连接断开
+    {
+        modbus_tcp_srv_release(srv, idx);
+        return(0);
+    }
+    return(cnt);
+}
+
+
+/**
+ * @brief  创建 Modbus TCP 服务器
+ *
+ * 一个线程服务多个客户端：监听 socket 和全部客户端 socket 统一多路复用，
+ * 每个客户端分配一个 SOCK 后端实例，所有客户端共享同一个回调函数表（寄存器映射）。
+ * 适用于 SCADA、HMI、历史库等多个主站同时访问同一设备，
+ * 不必为每个客户端创建线程和栈。
+ *
+ * @param[in] port      监听端口（通常 502）
+ * @param[in] max_conn  最大客户端连接数，<=0 或超过 MB_TCP_SRV_CONN_MAX 时使用 MB_TCP_SRV_CONN_MAX
+ *
+ * @return mb_tcp_srv_t*  成功返回服务器指针，失败返回 NULL
+ *
+ * @note
+ *   - 监听 socket 在首次调用 modbus_tcp_srv_poll() 时建立，网络未就绪时自动重试
+ *   - 启用 RT_USING_POSIX_POLL 时使用 poll() 阻塞等待，否则非阻塞轮询
+ */
+mb_tcp_srv_t *modbus_tcp_srv_create(uint16_t port, int max_conn)
+{
+    mb_tcp_srv_t *srv = calloc(1, sizeof(mb_tcp_srv_t));
+    if (srv == NULL)
+    {
+        return(NULL);
+    }
+
+    if ((max_conn <= 0) || (max_conn > MB_TCP_SRV_CONN_MAX))
+    {
+        max_conn = MB_TCP_SRV_CONN_MAX;
+    }
+
+    srv->lfd = -1;
+    srv->port = port;
+    srv->max_conn = max_conn;
+    srv->conn_cnt = 0;
+    srv->saddr = MB_RTU_ADDR_DEF;
+    srv->cb = NULL;
+    for (int i=0; i<MB_TCP_SRV_CONN_MAX; i++)
+    {
+        srv->fd[i] = -1;
+        srv->conn[i] = NULL;
+    }
+
+    return(srv);
+}
+
+
+/**
+ * @brief  销毁 Modbus TCP 服务器
+ *
+ * @param[in] srv  服务器指针
+ */
+void modbus_tcp_srv_destroy(mb_tcp_srv_t *srv)
+{
+    if (srv == NULL)
+    {
+        return;
+    }
+
+    for (int i=0; i<srv->max_conn; i++)
+    {
+        if (srv->conn[i] != NULL)
+        {
+            modbus_tcp_srv_release(srv, i);
+        }
+    }
+    if (srv->lfd >= 0)
+    {
+        closesocket(srv->lfd);
+        srv->lfd = -1;
+    }
+
+    free(srv);
+}
+
+
+/**
+ * @brief  修改全部连接共享的回调函数表
+ *
+ * 已建立的连接立即生效。
+ *
+ * @param[in] srv  服务器指针
+ * @param[in] cb   回调函数表
+ */
+void modbus_tcp_srv_set_cb_table(mb_tcp_srv_t *srv, const mb_cb_table_t *cb)
+{
+    MB_ASSERT(srv != NULL);
+    MB_ASSERT(cb != NULL);
+
+    srv->cb = cb;
+    for (int i=0; i<srv->max_conn; i++)
+    {
+        if (srv->conn[i] != NULL)
+        {
+            modbus_set_cb_table(srv->conn[i], cb);
+        }
+    }
+}
+
+
+/**
+ * @brief  修改从机地址（MBAP 单元标识）
+ *
+ * @param[in] srv    服务器指针
+ * @param[in] saddr  从机地址
+ */
+void modbus_tcp_srv_set_slave(mb_tcp_srv_t *srv, uint8_t saddr)
+{
+    MB_ASSERT(srv != NULL);
+
+    srv->saddr = saddr;
+    for (int i=0; i<srv->max_conn; i++)
+    {
+        if (srv->conn[i] != NULL)
+        {
+            modbus_set_slave_addr(srv->conn[i], saddr);
+        }
+    }
+}
+
+
+/**
+ * @brief  服务器处理
+ *
+ * 等待监听 socket 或任一客户端可读，接受新连接并处理已到达的请求。
+ * 在线程中循环调用即可。
+ *
+ * @param[in] srv     服务器指针
+ * @param[in] tmo_ms  最长等待时间（毫秒）
+ *
+ * @return int
+ *   - >=0 : 本次处理的请求数
+ *   -  -1 : 监听 socket 建立失败或等待出错
+ */
+int modbus_tcp_srv_poll(mb_tcp_srv_t *srv, int tmo_ms)
+{
+    MB_ASSERT(srv != NULL);
+
+    // 1. 监听 socket 未建立时创建, 失败延时返回
+    if (srv->lfd < 0)
+    {
+        if (modbus_tcp_srv_listen(srv) < 0)
+        {
+            modbus_port_delay_ms(1000);
+            return(-1);
+        }
+    }
+
+    int cnt = 0;
+
+    #ifdef RT_USING_POSIX_POLL
+    // 2. 监听 socket 和全部客户端统一等待
+    struct pollfd pfd[MB_TCP_SRV_CONN_MAX + 1];
+    int map[MB_TCP_SRV_CONN_MAX + 1];
+    int nfds = 0;
+    pfd[nfds].fd = srv->lfd;
+    pfd[nfds].events = POLLIN;
+    pfd[nfds].revents = 0;
+    map[nfds++] = -1;
+    for (int i=0; i<srv->max_conn; i++)
+    {
+        if (srv->conn[i] != NULL)
+        {
+            pfd[nfds].fd = srv->fd[i];
+            pfd[nfds].events = POLLIN;
+            pfd[nfds].revents = 0;
+            map[nfds++] = i;
+        }
+    }
+
+    int rst = poll(pfd, nfds, tmo_ms);
+    if (rst < 0)
+    {
+        LOG_E("poll error.");
+        return(-1);
+    }
+    if (rst == 0)
+    {
+        return(0);
+    }
+
+    // 3. 处理可读的客户端
+    for (int n=1; n<nfds; n++)
+    {
+        if (pfd[n].revents & (POLLIN | POLLERR | POLLHUP))
+        {
+            cnt += modbus_tcp_srv_service(srv, map[n]);
+        }
+    }
+
+    // 4. 接受新连接
+    if (pfd[0].revents & POLLIN)
+    {
+        modbus_tcp_srv_accept(srv);
+    }
+    #else
+    // 2. 无 poll 时非阻塞轮询全部连接, 空闲时每 2ms 轮询一次
+    long long told_ms = modbus_port_get_ms();
+    while(1)
+    {
+        int act = modbus_tcp_srv_accept(srv);
+        for (int i=0; i<srv->max_conn; i++)
+        {
+            if (srv->conn[i] != NULL)
+            {
+                int n = modbus_tcp_srv_service(srv, i);
+                act += n;
+                cnt += n;
+            }
+        }
+        if (act > 0)
+        {
+            break;
+        }
+        if ((modbus_port_get_ms() - told_ms) >= tmo_ms)
+        {
+            break;
+        }
+        modbus_port_delay_ms(2);
+    }
+    #endif
+
+    return(cnt);
+}
+
+#endif
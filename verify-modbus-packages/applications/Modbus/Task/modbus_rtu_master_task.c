@@ -21,7 +21,9 @@ static const mb_backend_param_t mb_bkd_prm = {
     .rtu.baudrate = 115200, //波特率
     .rtu.parity = 0,        //校验位, 0-无, 1-奇, 2-偶
     .rtu.pin = 79,          //控制引脚, <0 表示不使用
-    .rtu.lvl = 1            //控制发送电平
+    .rtu.lvl = 1,           //控制发送电平
+    .rtu.dma = 0,           //1-DMA收发(需开启串口DMA), 0-中断收发
+    .rtu.de_mode = 0        //DE控制: 0-软件, 1-发送完成中断释放, 2-USART硬件DE
 };
 
 
@@ -54,6 +56,7 @@ static void modbus_message_thread_entry(void *args)
 
     while(1)
     {
+        modbus_connect(modbus_hinst);//收发出错时后端已关闭, 在此重新打开串口
         modbus_write_reg(modbus_hinst, start_addr, write_value);
         rt_thread_mdelay(1000);
     }
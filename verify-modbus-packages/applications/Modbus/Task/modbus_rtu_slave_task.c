@@ -23,7 +23,9 @@ static const mb_backend_param_t mb_bkd_prm = {
     .rtu.baudrate = 115200,   //波特率
     .rtu.parity = 0,          //校验位, 0-无, 1-奇, 2-偶
     .rtu.pin = 79,            //控制引脚, <0 表示不使用
-    .rtu.lvl = 1              //控制发送电平
+    .rtu.lvl = 1,             //控制发送电平
+    .rtu.dma = 0,             //1-DMA收发(需开启串口DMA), 0-中断收发
+    .rtu.de_mode = 0          //DE控制: 0-软件, 1-发送完成中断释放, 2-USART硬件DE
 };
 
 #define MB_REG_ADDR_BEGIN   4000    //寄存器起始地址
@@ -96,11 +98,60 @@ int modbus_port_write_hold(uint16_t addr, uint16_t reg)//写保持寄存器, 返
     return(0);
 }
 
+//批量读保持寄存器: 一次越界检查 + 一次块拷贝, 返回 : 0-成功, -2-地址错误
+static int modbus_sample_read_hold_range(uint16_t addr, int nb, uint16_t *pregs)
+{
+    if ((addr < MB_REG_ADDR_BEGIN) || ((addr + nb) > (MB_REG_ADDR_BEGIN + (int)(sizeof(regs)/sizeof(regs[0])))))
+    {
+        return(-2);
+    }
+
+    memcpy(pregs, &regs[addr - MB_REG_ADDR_BEGIN], nb * sizeof(uint16_t));
+
+    return(0);
+}
+
+//批量写保持寄存器, 返回 : 0-成功, -2-地址错误, -3-值非法, -4-设备故障
+static int modbus_sample_write_hold_range(uint16_t addr, int nb, const uint16_t *pregs)
+{
+    if ((addr < MB_REG_ADDR_BEGIN) || ((addr + nb) > (MB_REG_ADDR_BEGIN + (int)(sizeof(regs)/sizeof(regs[0])))))
+    {
+        return(-2);
+    }
+
+    memcpy(&regs[addr - MB_REG_ADDR_BEGIN], pregs, nb * sizeof(uint16_t));
+
+    return(0);
+}
+
+#ifdef MB_USING_REGBANK
+static mb_reg_region_t mb_sample_regions[] = {//声明式存储区, 从机按区表直接应答
+    {MB_REG_TYPE_HOLD, MB_REG_ADDR_BEGIN, sizeof(regs)/sizeof(regs[0]), regs, NULL},
+};
+static mb_regbank_t mb_sample_bank;
+#else
+static mb_cb_table_t mb_sample_cb_table;
+#endif
+
 static void modbus_sample_thread(void *args)//线程服务函数
 {
     mb_inst_t *hinst = modbus_create(MB_BACKEND_TYPE_RTU, &mb_bkd_prm);
     RT_ASSERT(hinst != NULL);
 
+    #ifdef MB_USING_REGBANK
+    //使用寄存器库, 不再经过回调函数
+    int rc = modbus_regbank_init(&mb_sample_bank, mb_sample_regions, sizeof(mb_sample_regions)/sizeof(mb_sample_regions[0]));
+    RT_ASSERT(rc == 0);
+    RT_UNUSED(rc);
+    modbus_set_regbank(hinst, &mb_sample_bank);
+    #else
+    //在缺省回调表基础上增加批量回调, 寄存器为连续数组时整块读写
+    mb_sample_cb_table = mb_cb_table;
+    mb_sample_cb_table.read_hold_range = modbus_sample_read_hold_range;
+    mb_sample_cb_table.write_hold_range = modbus_sample_write_hold_range;
+    modbus_set_cb_table(hinst, &mb_sample_cb_table);
+    #endif
+
     //mb_set_slave(hinst, 1);//修改从机地址, 默认地址为1, 可根据实际情况修改
     //mb_set_prot(hinst, MB_PROT_TCP);//修改通信协议类型, RTU后端默认使用MODBUS-RTU通信协议
     //mb_set_tmo(hinst, 500, 15);//修改超时时间, 应答超时500ms(默认300ms), 字节超时15ms(默认32ms)
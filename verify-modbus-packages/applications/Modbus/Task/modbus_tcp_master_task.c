@@ -48,6 +48,45 @@ static void modbus_sample_read_regs(mb_inst_t *hinst)
     }
 }
 
+#ifdef MB_USING_TCP_PIPELINE
+static void modbus_sample_pipe_cb(void *arg, int rst, const uint8_t *pdata, int dlen)
+{
+    int addr = (int)(rt_ubase_t)arg;
+    if (rst <= 0)
+    {
+        LOG_E("modbus pipe read %d fail, rst : %d.", addr, rst);
+        return;
+    }
+
+    for (int i=0; i<dlen/2; i++)
+    {
+        uint16_t val;
+        modbus_cvt_u16_get(pdata + i * 2, &val);
+        LOG_D("addr : %d, value : %d", addr + i, val);
+    }
+}
+
+static void modbus_sample_pipe_read_regs(mb_pipe_t *pipe)
+{
+    if (modbus_connect(pipe->hinst) < 0)//连接失败, 延时返回
+    {
+        LOG_E("modbus connect fail.");
+        return;
+    }
+
+    //4个请求同时在途, 响应按事务标识匹配后回调
+    for (int addr = 4000; addr < 4000 + 4 * 29; addr += 29)
+    {
+        if (modbus_pipe_read_req(pipe, MODBUS_FC_READ_HOLDING_REGISTERS, addr, 29, modbus_sample_pipe_cb, (void *)(rt_ubase_t)addr) < 0)
+        {
+            LOG_E("modbus pipe submit fail.");
+            break;
+        }
+    }
+    modbus_pipe_wait_all(pipe);
+}
+#endif
+
 static void modbus_sample_thread(void *args)//线程服务函数
 {
     mb_inst_t *hinst = modbus_create(MB_BACKEND_TYPE_TCP, &mb_bkd_prm);
@@ -57,9 +96,18 @@ static void modbus_sample_thread(void *args)//线程服务函数
     //mb_set_prot(hinst, MB_PROT_RTU);//修改通信协议类型, TCP后端默认使用MODBUS-TCP通信协议
     //mb_set_tmo(hinst, 500, 15);//修改超时时间, 应答超时500ms(默认300ms), 字节超时15ms(默认32ms)
 
+    #ifdef MB_USING_TCP_PIPELINE
+    mb_pipe_t *pipe = modbus_pipe_create(hinst, 4);
+    RT_ASSERT(pipe != NULL);
+    #endif
+
     while(1)
     {
+        #ifdef MB_USING_TCP_PIPELINE
+        modbus_sample_pipe_read_regs(pipe);
+        #else
         modbus_sample_read_regs(hinst);
+        #endif
         rt_thread_mdelay(1000);
     }
 }
@@ -10,13 +10,93 @@
 #include "bsp_sys.h"
 
 
+#if (defined(MB_USING_TCP_SRV_SLAVE) && defined(MB_USING_TCP_SERVER))
 
+#define DBG_TAG "mb.tcp.slave"
+#define DBG_LVL DBG_LOG
+#include <rtdbg.h>
 
+#define MB_SRV_PORT         502     //监听端口
+#define MB_SRV_CONN_MAX     4       //最大客户端连接数
 
+#define MB_REG_ADDR_BEGIN   4000    //寄存器起始地址
 
+static uint16_t regs[] = {//寄存器数据, 全部客户端共享
+    2210,
+    2220,
+    2230,
+    111,
+    112,
+    113,
+    3000,
+    1111,
+    1112,
+    1113
+};
 
+static int modbus_sample_read_hold(uint16_t addr, uint16_t *preg)//读保持寄存器, 返回 : 0-成功, -2-地址错误
+{
+    MB_ASSERT(preg != NULL);
 
+    if (addr < MB_REG_ADDR_BEGIN)
+    {
+        return(-2);
+    }
+    if (addr >= (MB_REG_ADDR_BEGIN + sizeof(regs)/sizeof(regs[0])))
+    {
+        return(-2);
+    }
 
+    *preg = regs[addr - MB_REG_ADDR_BEGIN];
+
+    return(0);
+}
+
+static int modbus_sample_write_hold(uint16_t addr, uint16_t reg)//写保持寄存器, 返回 : 0-成功, -2-地址错误, -3-值非法, -4-设备故障
+{
+    if (addr < MB_REG_ADDR_BEGIN)
+    {
+        return(-2);
+    }
+    if (addr >= (MB_REG_ADDR_BEGIN + sizeof(regs)/sizeof(regs[0])))
+    {
+        return(-2);
+    }
+
+    regs[addr - MB_REG_ADDR_BEGIN] = reg;
+
+    return(0);
+}
+
+static const mb_cb_table_t mb_sample_cb_table = {//未提供的回调以非法功能应答
+    .read_hold = modbus_sample_read_hold,      //读保持寄存器
+    .write_hold = modbus_sample_write_hold,    //写保持寄存器
+};
+
+static void modbus_sample_thread(void *args)//线程服务函数
+{
+    mb_tcp_srv_t *srv = modbus_tcp_srv_create(MB_SRV_PORT, MB_SRV_CONN_MAX);
+    RT_ASSERT(srv != NULL);
+
+    modbus_tcp_srv_set_cb_table(srv, &mb_sample_cb_table);//全部客户端共享同一寄存器映射
+    //modbus_tcp_srv_set_slave(srv, 1);//修改从机地址, 默认地址为1, 可根据实际情况修改
+
+    while(1)
+    {
+        modbus_tcp_srv_poll(srv, 1000);//循环调用服务器处理, 单线程服务全部客户端
+    }
+}
+
+static int modbus_sample_tcp_slave_startup(void)
+{
+    rt_thread_t tid = rt_thread_create("mb-tcp-slave", modbus_sample_thread, NULL, 2048, 5, 20);
+    RT_ASSERT(tid != NULL);
+    rt_thread_startup(tid);
+    return(0);
+}
+INIT_APP_EXPORT(modbus_sample_tcp_slave_startup);
+
+#endif
 
 
 
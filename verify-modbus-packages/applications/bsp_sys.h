@@ -34,8 +34,16 @@
 #include "modbus_crc.h"
 #include "modbus_instance.h"
 #include "modbus_pdu.h"
+#include "modbus_queue.h"
+#include "modbus_regbank.h"
+#include "modbus_sched.h"
+#include "modbus_coalesce.h"
+#include "modbus_bus.h"
+#include "modbus_cache.h"
 #include "modbus_rtu.h"
 #include "modbus_tcp.h"
+#include "modbus_tcp_pipe.h"
+#include "modbus_tcp_srv.h"
 #include "modbus_config.h"
 
 